@@ -6,6 +6,8 @@
 #include <list>
 #include <optional>
 #include <initializer_list>
+#include <tuple>
+#include <utility>
 
 #include "record.hpp"
 
@@ -81,23 +83,73 @@ public:
         return !m_size;
     }
 
+    // the record is built straight in its list node, key and value are moved or copied in exactly once
     Record<K, V>& set(K &&key, V &&value)
     {
-        Record<K, V> item(std::forward<K>(key), std::forward<V>(value));
-        return set_item(item);
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::move(value)));
     }
 
     Record<K, V>& set(const K &key, V &&value)
     {
-        Record<K, V> item(key, value);
-        return set_item(item);
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value)));
     }
 
+    Record<K, V>& set(const K &key, const V &value)
+    {
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value));
+    }
+
+    // a takes any Record constructor's arguments, including the piecewise one
     template<class ...A>
     Record<K, V>& emplace(A &&...a)
     {
-        Record<K, V> item(a...);
-        return set_item(item);
+        return emplace_item(std::forward<A>(a)...);
+    }
+
+    // the value is constructed from a only if key is not there yet, otherwise nothing is touched
+    // returns the record with the key and whether it was inserted
+    template<class ...A>
+    std::pair<Record<K, V>&, bool> try_emplace(const K &key, A &&...a)
+    {
+        if (Record<K, V> *item = search_record(key))
+            return { *item, false };
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<A>(a)...)), true };
+    }
+
+    template<class ...A>
+    std::pair<Record<K, V>&, bool> try_emplace(K &&key, A &&...a)
+    {
+        if (Record<K, V> *item = search_record(key))
+            return { *item, false };
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<A>(a)...)), true };
+    }
+
+    // assigns value to the key if it is there, keeping its place in the order, and appends it if not
+    // returns whether it was inserted
+    template<class M>
+    std::pair<Record<K, V>&, bool> insert_or_assign(const K &key, M &&value)
+    {
+        if (Record<K, V> *item = search_record(key))
+        {
+            item->value = std::forward<M>(value);
+            return { *item, false };
+        }
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<M>(value))), true };
+    }
+
+    template<class M>
+    std::pair<Record<K, V>&, bool> insert_or_assign(K &&key, M &&value)
+    {
+        if (Record<K, V> *item = search_record(key))
+        {
+            item->value = std::forward<M>(value);
+            return { *item, false };
+        }
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<M>(value))), true };
     }
 
     // returns a pointer instead of an optional because realistically it would end in the same operation ie checking if its valid and using it
@@ -109,12 +161,7 @@ public:
 
     V& operator[](const K &key)
     {
-        V *value = search(key);
-
-        if (!value)
-            return set(key, V()).value;
-
-        return *value;
+        return try_emplace(key).first.value;
     }
 
     V& get(const K &key, const V &def_value) const
@@ -191,17 +238,15 @@ private:
     std::list<Record<K, V>> m_items;
     std::hash<K> m_hash;
 
-    Record<K, V>& set_item(Record<K, V> &item)
+    // the record is constructed at the end of the item list where it stays, the bucket only gets an iterator to it
+    template<class ...A>
+    Record<K, V>& emplace_item(A &&...a)
     {
         if (++m_size >= m_capacity)
             rehash();
 
-        size_t h = hash(item.key);
-
-        Chain &chain = m_bucket[h];
-
-        IterType iter = m_items.emplace(m_items.end(), std::move(item));
-        chain.emplace_back(iter);
+        IterType iter = m_items.emplace(m_items.end(), std::forward<A>(a)...);
+        m_bucket[hash(iter->key)].emplace_back(iter);
 
         return *iter;
     }
@@ -212,18 +257,24 @@ private:
         return m_hash(k) % m_capacity;
     }
 
-    V* search(const K &key) const
+    Record<K, V>* search_record(const K &key) const
     {
         size_t h = hash(key);
 
         for (IterType item : m_bucket[h])
         {
             if (item->key == key)
-                return &item->value;
+                return &*item;
         }
         return nullptr;
     }
 
+    V* search(const K &key) const
+    {
+        Record<K, V> *record = search_record(key);
+        return record ? &record->value : nullptr;
+    }
+
     inline void construct(int n)
     {
         m_capacity = n;
@@ -242,23 +293,15 @@ private:
 
         size_t i;
 
+        // the bucket nodes are relinked into their new chains, nothing is allocated
         for (i = 0; i < n; i++)
         {
-            temp[i] = Chain();
             Chain &old = m_bucket[i];
 
-            if (old.empty())
-                continue;
-
-            for (IterType item : old)
+            while (!old.empty())
             {
-                size_t h = hash(item->key);
-                Chain *chain = &temp[h];
-
-                if (!chain)
-                    temp[h] = Chain();
-
-                chain->push_back(item);
+                Chain &chain = temp[hash(old.front()->key)];
+                chain.splice(chain.end(), old, old.begin());
             }
         }
 
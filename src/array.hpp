@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <initializer_list>
 #include <cassert>
 #include <stdexcept>
@@ -9,23 +10,21 @@ class Array
 {
 public:
 
-	Array(std::initializer_list<T> items)
+    // items past the ones given are value initialized
+	constexpr Array(std::initializer_list<T> items)
 	{
+        if(items.size() > N)
+            throw std::out_of_range("Too many items for the array");
+
         size_t i = 0;
 
         for(auto &item : items)
         {
-            m_data[i++] = std::move(item);
+            m_data[i++] = item;
         }
 	}
 
-    Array()
-    {
-        for (int i = 0; i < N; i++)
-        {
-            m_data[i++] = T();
-        }
-    }
+    constexpr Array() = default;
 
     [[nodiscard]]
     inline constexpr
@@ -55,6 +54,34 @@ public:
         return m_data[N - 1];
     }
 
+    [[nodiscard]]
+    inline constexpr
+	const T& at(size_t index) const
+    {
+        return get_element(index);
+    }
+
+    [[nodiscard]]
+    inline constexpr
+	const T& operator[](size_t index) const
+    {
+        return get_element(index);
+    }
+
+    [[nodiscard]]
+    inline constexpr
+	const T& front() const
+    {
+        return m_data[0];
+    }
+
+    [[nodiscard]]
+    inline constexpr
+	const T& back() const
+    {
+        return m_data[N - 1];
+    }
+
     [[nodiscard]]
     inline constexpr
     T* begin()
@@ -69,6 +96,20 @@ public:
         return &m_data[N];
     }
 
+    [[nodiscard]]
+    inline constexpr
+    const T* begin() const
+    {
+        return m_data;
+    }
+
+    [[nodiscard]]
+    inline constexpr
+    const T* end() const
+    {
+        return &m_data[N];
+    }
+
     [[nodiscard]]
     inline constexpr
 	T* data()
@@ -76,6 +117,20 @@ public:
         return m_data;
     }
 
+    [[nodiscard]]
+    inline constexpr
+	const T* data() const
+    {
+        return m_data;
+    }
+
+    inline constexpr
+    void fill(const T& item)
+    {
+        for(size_t i = 0; i < N; i++)
+            m_data[i] = item;
+    }
+
     [[nodiscard]]
     inline constexpr
 	bool empty() const
@@ -90,8 +145,21 @@ public:
         return N;
     };
 
+    [[nodiscard]]
+    friend constexpr bool operator==(const Array& a, const Array& b)
+    {
+        for(size_t i = 0; i < N; i++)
+        {
+            if(!(a.m_data[i] == b.m_data[i]))
+                return false;
+        }
+
+        return true;
+    }
+
 private:
-	T m_data[N];
+    // value initialized so a default constructed array can be used in constant expressions
+	T m_data[N]{};
 
     inline constexpr
     T& get_element(size_t index)
@@ -102,4 +170,14 @@ private:
         }
 		return m_data[index];
 	}
+
+    inline constexpr
+    const T& get_element(size_t index) const
+	{
+		if (index >= N)
+        {
+			throw std::out_of_range("Provided index is out of bounds");
+        }
+		return m_data[index];
+	}
 };
\ No newline at end of file
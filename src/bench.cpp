@@ -0,0 +1,600 @@
+// runs every container next to its std counterpart and writes the timings as json
+//
+//     dna_bench [--filter text] [--warmup n] [--repetitions n] [--min-sample seconds] [--json path]
+//
+// the json goes to dna_bench.json unless a path is given, with --json - it goes to stdout and the progress to stderr
+// inputs come from a fixed seed so two runs time the same work
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <forward_list>
+#include <map>
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <fstream>
+#include <iostream>
+
+#include "bench.hpp"
+#include "vector.hpp"
+#include "sorting.hpp"
+#include "string.hpp"
+#include "map.hpp"
+#include "OMap.hpp"
+#include "rbt.hpp"
+#include "bst.hpp"
+#include "trie.hpp"
+#include "graph.hpp"
+#include "forward_list.hpp"
+#include "double_list.hpp"
+#include "math.hpp"
+
+static std::vector<uint64_t> random_numbers(size_t count, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> output(count);
+
+    for(auto &number : output)
+        number = rng();
+
+    return output;
+}
+
+// distinct keys in random order, the maps here do not all reject duplicates
+static std::vector<uint64_t> random_keys(size_t count, uint64_t seed)
+{
+    std::vector<uint64_t> output(count);
+
+    for(size_t i = 0; i < count; i++)
+        output[i] = uint64_t(i) * 0x9E3779B97F4A7C15ull;
+
+    std::shuffle(output.begin(), output.end(), std::mt19937_64(seed));
+
+    return output;
+}
+
+static void vector_suite(bench::Suite &suite)
+{
+    const size_t items = 1 << 20;
+    const size_t sorted = 1 << 18;
+
+    suite.run("vector", "push_back", "Vector", items, [&]
+    {
+        Vector<uint64_t> vec;
+        for(size_t i = 0; i < items; i++)
+            vec.push_back(i);
+        bench::do_not_optimize(vec);
+    });
+
+    suite.run("vector", "push_back", "std::vector", items, [&]
+    {
+        std::vector<uint64_t> vec;
+        for(size_t i = 0; i < items; i++)
+            vec.push_back(i);
+        bench::do_not_optimize(vec);
+    });
+
+    auto numbers = random_numbers(items, 1);
+
+    Vector<uint64_t>      vec;
+    std::vector<uint64_t> std_vec(numbers.begin(), numbers.end());
+
+    vec.reserve(items + 1);
+
+    for(uint64_t number : numbers)
+        vec.push_back(number);
+
+    suite.run("vector", "sum", "Vector", items, [&]
+    {
+        uint64_t total = vec.sum();
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("vector", "sum", "std::vector", items, [&]
+    {
+        uint64_t total = std::accumulate(std_vec.begin(), std_vec.end(), uint64_t(0));
+        bench::do_not_optimize(total);
+    });
+
+    // the copy is part of the time for both so each run sorts the same shuffled input
+    Vector<uint64_t>      unsorted = vec.slice(0, sorted);
+    std::vector<uint64_t> std_unsorted(numbers.begin(), numbers.begin() + sorted);
+
+    suite.run("vector", "sort", "Vector", sorted, [&]
+    {
+        Vector<uint64_t> copy = unsorted;
+        sort(copy, [](uint64_t a, uint64_t b) { return a < b; });
+        bench::do_not_optimize(copy);
+    });
+
+    suite.run("vector", "sort", "std::vector", sorted, [&]
+    {
+        std::vector<uint64_t> copy = std_unsorted;
+        std::sort(copy.begin(), copy.end());
+        bench::do_not_optimize(copy);
+    });
+}
+
+static void string_suite(bench::Suite &suite)
+{
+    // String appends by finding the end of the text every time so this stays small
+    const size_t appended = 1 << 14;
+    const size_t scanned  = 1 << 20;
+
+    suite.run("string", "append_char", "String", appended, [&]
+    {
+        String text;
+        for(size_t i = 0; i < appended; i++)
+            text += char('a' + i % 26);
+        bench::do_not_optimize(text);
+    });
+
+    suite.run("string", "append_char", "std::string", appended, [&]
+    {
+        std::string text;
+        for(size_t i = 0; i < appended; i++)
+            text += char('a' + i % 26);
+        bench::do_not_optimize(text);
+    });
+
+    std::string std_text(scanned, 'a');
+
+    for(size_t i = 0; i < scanned; i++)
+        std_text[i] = char('a' + i % 26);
+
+    String text(scanned + 1);
+    text = std_text.c_str();
+
+    // a character that is not there so the whole text is read
+    suite.run("string", "find_char", "String", scanned, [&]
+    {
+        size_t index = text.index_of('#');
+        bench::do_not_optimize(index);
+    });
+
+    suite.run("string", "find_char", "std::string", scanned, [&]
+    {
+        size_t index = std_text.find('#');
+        bench::do_not_optimize(index);
+    });
+}
+
+static void map_suite(bench::Suite &suite)
+{
+    const size_t items = 1 << 16;
+
+    auto keys   = random_keys(items, 2);
+    auto lookup = keys;
+
+    std::shuffle(lookup.begin(), lookup.end(), std::mt19937_64(3));
+
+    suite.run("map", "insert", "Map", items, [&]
+    {
+        Map<uint64_t, uint64_t> map;
+        for(uint64_t key : keys)
+            map.set(key, key);
+        bench::do_not_optimize(map);
+    });
+
+    suite.run("map", "insert", "OMap", items, [&]
+    {
+        OMap<uint64_t, uint64_t> map;
+        for(uint64_t key : keys)
+            map.set(key, key);
+        bench::do_not_optimize(map);
+    });
+
+    suite.run("map", "insert", "std::unordered_map", items, [&]
+    {
+        std::unordered_map<uint64_t, uint64_t> map;
+        for(uint64_t key : keys)
+            map.emplace(key, key);
+        bench::do_not_optimize(map);
+    });
+
+    Map<uint64_t, uint64_t>                map;
+    OMap<uint64_t, uint64_t>               omap;
+    std::unordered_map<uint64_t, uint64_t> std_map;
+
+    for(uint64_t key : keys)
+    {
+        map.set(key, key);
+        omap.set(key, key);
+        std_map.emplace(key, key);
+    }
+
+    suite.run("map", "get", "Map", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += *map.get(key);
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("map", "get", "OMap", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += *omap.get(key);
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("map", "get", "std::unordered_map", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += std_map.find(key)->second;
+        bench::do_not_optimize(total);
+    });
+}
+
+// the trees get their keys in random order, sorted keys would turn the BST into a list
+static void tree_suite(bench::Suite &suite)
+{
+    const size_t items = 1 << 16;
+
+    auto keys   = random_keys(items, 4);
+    auto lookup = keys;
+
+    std::shuffle(lookup.begin(), lookup.end(), std::mt19937_64(5));
+
+    suite.run("tree", "insert", "RBT", items, [&]
+    {
+        RBT<uint64_t, uint64_t> tree;
+        for(uint64_t key : keys)
+            tree.insert(key, key);
+        bench::do_not_optimize(tree);
+    });
+
+    suite.run("tree", "insert", "BST", items, [&]
+    {
+        BST<uint64_t, uint64_t> tree;
+        for(uint64_t key : keys)
+            tree.insert(key, key);
+        bench::do_not_optimize(tree);
+    });
+
+    suite.run("tree", "insert", "std::map", items, [&]
+    {
+        std::map<uint64_t, uint64_t> tree;
+        for(uint64_t key : keys)
+            tree.emplace(key, key);
+        bench::do_not_optimize(tree);
+    });
+
+    RBT<uint64_t, uint64_t>      rbt;
+    BST<uint64_t, uint64_t>      bst;
+    std::map<uint64_t, uint64_t> std_tree;
+
+    for(uint64_t key : keys)
+    {
+        rbt.insert(key, key);
+        bst.insert(key, key);
+        std_tree.emplace(key, key);
+    }
+
+    suite.run("tree", "find", "RBT", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += rbt.find(key);
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("tree", "find", "BST", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += bst.find(key)->value;
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("tree", "find", "std::map", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t key : lookup)
+            total += std_tree.find(key)->second;
+        bench::do_not_optimize(total);
+    });
+}
+
+// a Trie node holds a pointer per character so the key count is kept low
+static void trie_suite(bench::Suite &suite)
+{
+    const size_t items = 1 << 12;
+
+    std::vector<std::string> keys;
+    keys.reserve(items);
+
+    for(uint64_t number : random_numbers(items, 6))
+        keys.push_back("key/" + std::to_string(number % 1000000007));
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+
+    suite.run("trie", "set", "Trie", keys.size(), [&]
+    {
+        Trie<uint64_t> trie;
+        for(size_t i = 0; i < keys.size(); i++)
+            trie.set(keys[i], uint64_t(i));
+        bench::do_not_optimize(trie);
+    });
+
+    suite.run("trie", "set", "std::map", keys.size(), [&]
+    {
+        std::map<std::string, uint64_t> map;
+        for(size_t i = 0; i < keys.size(); i++)
+            map.emplace(keys[i], uint64_t(i));
+        bench::do_not_optimize(map);
+    });
+
+    Trie<uint64_t>                  trie;
+    std::map<std::string, uint64_t> map;
+
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        trie.set(keys[i], uint64_t(i));
+        map.emplace(keys[i], uint64_t(i));
+    }
+
+    suite.run("trie", "get", "Trie", keys.size(), [&]
+    {
+        uint64_t total = 0;
+        for(const auto &key : keys)
+            total += *trie.get(key);
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("trie", "get", "std::map", keys.size(), [&]
+    {
+        uint64_t total = 0;
+        for(const auto &key : keys)
+            total += map.find(key)->second;
+        bench::do_not_optimize(total);
+    });
+}
+
+// against an adjacency list indexed by vertex, the same layout without the hash map in front
+static void graph_suite(bench::Suite &suite)
+{
+    const size_t vertices = 1 << 14;
+    const size_t edges    = 1 << 16;
+
+    auto ends = random_numbers(edges * 2, 8);
+
+    for(auto &end : ends)
+        end %= vertices;
+
+    suite.run("graph", "add_edge", "Graph", edges, [&]
+    {
+        Graph<uint32_t> graph;
+        for(size_t i = 0; i < edges; i++)
+            graph.add_edge(uint32_t(ends[2 * i]), uint32_t(ends[2 * i + 1]));
+        bench::do_not_optimize(graph);
+    });
+
+    suite.run("graph", "add_edge", "std::vector<std::vector>", edges, [&]
+    {
+        std::vector<std::vector<uint32_t>> graph(vertices);
+        for(size_t i = 0; i < edges; i++)
+        {
+            graph[ends[2 * i]].push_back(uint32_t(ends[2 * i + 1]));
+            graph[ends[2 * i + 1]].push_back(uint32_t(ends[2 * i]));
+        }
+        bench::do_not_optimize(graph);
+    });
+
+    Graph<uint32_t>                    graph;
+    std::vector<std::vector<uint32_t>> std_graph(vertices);
+
+    for(size_t i = 0; i < edges; i++)
+    {
+        graph.add_edge(uint32_t(ends[2 * i]), uint32_t(ends[2 * i + 1]));
+        std_graph[ends[2 * i]].push_back(uint32_t(ends[2 * i + 1]));
+        std_graph[ends[2 * i + 1]].push_back(uint32_t(ends[2 * i]));
+    }
+
+    // every vertex's neighbours once, the inner loop of a traversal
+    suite.run("graph", "neighbours", "Graph", edges * 2, [&]
+    {
+        uint64_t total = 0;
+        for(uint32_t v = 0; v < vertices; v++)
+            for(uint32_t w : graph.adjc(v))
+                total += w;
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("graph", "neighbours", "std::vector<std::vector>", edges * 2, [&]
+    {
+        uint64_t total = 0;
+        for(uint32_t v = 0; v < vertices; v++)
+            for(uint32_t w : std_graph[v])
+                total += w;
+        bench::do_not_optimize(total);
+    });
+}
+
+static void list_suite(bench::Suite &suite)
+{
+    const size_t items = 1 << 16;
+
+    suite.run("list", "push_back", "Forward_List", items, [&]
+    {
+        Forward_List<uint64_t> list;
+        for(size_t i = 0; i < items; i++)
+            list.push_back(i);
+        bench::do_not_optimize(list);
+    });
+
+    suite.run("list", "push_back", "std::forward_list", items, [&]
+    {
+        std::forward_list<uint64_t> list;
+        auto tail = list.before_begin();
+        for(size_t i = 0; i < items; i++)
+            tail = list.insert_after(tail, i);
+        bench::do_not_optimize(list);
+    });
+
+    suite.run("list", "push_back", "List", items, [&]
+    {
+        List<uint64_t> list;
+        for(size_t i = 0; i < items; i++)
+            list.push_back(i);
+        bench::do_not_optimize(list);
+    });
+
+    suite.run("list", "push_back", "std::list", items, [&]
+    {
+        std::list<uint64_t> list;
+        for(size_t i = 0; i < items; i++)
+            list.push_back(i);
+        bench::do_not_optimize(list);
+    });
+
+    Forward_List<uint64_t>      list;
+    std::forward_list<uint64_t> std_list;
+    auto tail = std_list.before_begin();
+
+    for(size_t i = 0; i < items; i++)
+    {
+        list.push_back(i);
+        tail = std_list.insert_after(tail, i);
+    }
+
+    suite.run("list", "iterate", "Forward_List", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t item : list)
+            total += item;
+        bench::do_not_optimize(total);
+    });
+
+    suite.run("list", "iterate", "std::forward_list", items, [&]
+    {
+        uint64_t total = 0;
+        for(uint64_t item : std_list)
+            total += item;
+        bench::do_not_optimize(total);
+    });
+}
+
+// every prime below the limit, against a plain sieve over std::vector<bool>
+static void prime_suite(bench::Suite &suite)
+{
+    const size_t limit = 1 << 22;
+
+    suite.run("prime", "sieve", "Prime::eratosthenes", limit, [&]
+    {
+        auto primes = Prime::eratosthenes(0, limit);
+        bench::do_not_optimize(primes);
+    });
+
+    suite.run("prime", "sieve", "Prime::sundaram", limit, [&]
+    {
+        auto primes = Prime::sundaram(0, limit);
+        bench::do_not_optimize(primes);
+    });
+
+    suite.run("prime", "sieve", "Prime::segmented", limit, [&]
+    {
+        auto primes = Prime::segmented(0, limit, 1);
+        bench::do_not_optimize(primes);
+    });
+
+    suite.run("prime", "sieve", "std::vector<bool>", limit, [&]
+    {
+        std::vector<bool> composite(limit);
+        std::vector<size_t> primes;
+
+        for(size_t i = 2; i < limit; i++)
+        {
+            if(composite[i])
+                continue;
+
+            primes.push_back(i);
+
+            for(size_t j = i * i; j < limit; j += i)
+                composite[j] = true;
+        }
+
+        bench::do_not_optimize(primes);
+    });
+
+    suite.run("prime", "count", "Prime::count", limit, [&]
+    {
+        size_t count = Prime::count(0, limit, 1);
+        bench::do_not_optimize(count);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    bench::Options options;
+    std::string    json = "dna_bench.json";
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+
+        if(i + 1 >= argc)
+        {
+            std::cerr << "missing a value after " << arg << '\n';
+            return 1;
+        }
+
+        const char *value = argv[++i];
+
+        if(arg == "--filter")
+            options.filter = value;
+        else if(arg == "--warmup")
+            options.warmup = std::strtoull(value, nullptr, 10);
+        else if(arg == "--repetitions")
+            options.repetitions = std::strtoull(value, nullptr, 10);
+        else if(arg == "--min-sample")
+            options.min_sample = std::strtod(value, nullptr);
+        else if(arg == "--json")
+            json = value;
+        else
+        {
+            std::cerr << "unknown option " << arg << '\n';
+            return 1;
+        }
+    }
+
+    bool to_stdout = json == "-";
+
+    bench::Suite suite(to_stdout ? std::cerr : std::cout, options);
+
+    vector_suite(suite);
+    string_suite(suite);
+    map_suite(suite);
+    tree_suite(suite);
+    trie_suite(suite);
+    graph_suite(suite);
+    list_suite(suite);
+    prime_suite(suite);
+
+    if(to_stdout)
+    {
+        suite.write_json(std::cout);
+        return 0;
+    }
+
+    std::ofstream file(json);
+
+    if(!file)
+    {
+        std::cerr << "can not write " << json << '\n';
+        return 1;
+    }
+
+    suite.write_json(file);
+    std::cout << "wrote " << json << '\n';
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+
+#include "simd.hpp"
+
+// a microbenchmark harness for timing the containers against their std counterparts
+//
+//     bench::Suite suite(std::cout);
+//     suite.run("vector", "push_back", "Vector", n, [&]
+//     {
+//         Vector<size_t> vec;
+//         for(size_t i = 0; i < n; i++)
+//             vec.push_back(i);
+//         bench::do_not_optimize(vec);
+//     });
+//     suite.write_json(file);
+//
+// every case is warmed up and then timed for a number of repetitions, a repetition runs the case as many times
+// as it takes to last min_sample so short cases are not lost in the clock's resolution
+// times are kept in nanoseconds per item so cases of different sizes line up
+namespace bench
+{
+    // the compiler has to assume value is read, so the work that produced it can not be thrown away
+    template<typename T>
+    inline void do_not_optimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // the compiler also has to assume value was changed, so it can not be folded into the next run
+    template<typename T>
+    inline void do_not_optimize(T &value)
+    {
+        if constexpr(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(T*))
+            asm volatile("" : "+m,r"(value) : : "memory");
+        else
+            asm volatile("" : "+m"(value) : : "memory");
+    }
+
+    // every store before this is done by the time it returns
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    struct Options
+    {
+        // runs thrown away before timing, at least one always happens to size the repetitions
+        size_t      warmup      = 2;
+        size_t      repetitions = 15;
+        // seconds a repetition lasts at least
+        double      min_sample  = 0.005;
+        // only the cases whose group/name/impl contains this are run
+        std::string filter;
+    };
+
+    // nanoseconds per item over the repetitions
+    struct Stats
+    {
+        double min    = 0;
+        double p10    = 0;
+        double median = 0;
+        double p90    = 0;
+        double max    = 0;
+        double mean   = 0;
+        double stddev = 0;
+    };
+
+    struct Result
+    {
+        std::string group;
+        std::string name;
+        std::string impl;
+        size_t      items = 0;
+        // runs of the case in one repetition
+        size_t      batch = 0;
+        Stats       stats;
+    };
+
+    // p in [0, 1], interpolates between the two closest samples, samples has to be sorted
+    inline double percentile(const std::vector<double> &samples, double p)
+    {
+        if(samples.empty())
+            return 0;
+
+        double rank = p * double(samples.size() - 1);
+        size_t low  = size_t(rank);
+        size_t high = low + 1 < samples.size() ? low + 1 : low;
+
+        return samples[low] + (samples[high] - samples[low]) * (rank - double(low));
+    }
+
+    inline Stats summarize(std::vector<double> samples)
+    {
+        Stats stats;
+
+        if(samples.empty())
+            return stats;
+
+        std::sort(samples.begin(), samples.end());
+
+        double total = 0;
+
+        for(double sample : samples)
+            total += sample;
+
+        stats.mean = total / double(samples.size());
+
+        double spread = 0;
+
+        for(double sample : samples)
+            spread += (sample - stats.mean) * (sample - stats.mean);
+
+        stats.stddev = samples.size() > 1 ? std::sqrt(spread / double(samples.size() - 1)) : 0;
+        stats.min    = samples.front();
+        stats.p10    = percentile(samples, 0.1);
+        stats.median = percentile(samples, 0.5);
+        stats.p90    = percentile(samples, 0.9);
+        stats.max    = samples.back();
+
+        return stats;
+    }
+
+    // quotes and backslashes are escaped, the names are ours so nothing else shows up
+    inline std::string json_string(std::string_view text)
+    {
+        std::string output = "\"";
+
+        for(char c : text)
+        {
+            if(c == '"' || c == '\\')
+                output += '\\';
+            output += c;
+        }
+
+        return output + '"';
+    }
+
+    class Suite
+    {
+    public:
+
+        // a line per case goes to log as it finishes
+        explicit Suite(std::ostream &log, Options options = {}) :
+                m_log(log),
+                m_options(std::move(options))
+        {}
+
+        // one call of fn does the work for all the items, whatever it builds is torn down inside the timed region too
+        template<typename FN>
+        void run(std::string_view group, std::string_view name, std::string_view impl, size_t items, FN &&fn)
+        {
+            std::string id = std::string(group) + '/' + std::string(name) + '/' + std::string(impl);
+
+            if(!m_options.filter.empty() && id.find(m_options.filter) == std::string::npos)
+                return;
+
+            if(items == 0)
+                items = 1;
+
+            // the last warmup run is the one with warm caches so it decides the batch
+            double once = 0;
+
+            for(size_t i = 0; i < std::max<size_t>(m_options.warmup, 1); i++)
+                once = time(fn, 1);
+
+            size_t batch = once >= m_options.min_sample ? 1 : size_t(std::ceil(m_options.min_sample / std::max(once, 1e-9)));
+
+            std::vector<double> samples;
+            samples.reserve(m_options.repetitions);
+
+            for(size_t i = 0; i < std::max<size_t>(m_options.repetitions, 1); i++)
+                samples.push_back(time(fn, batch) * 1e9 / double(batch * items));
+
+            Result result{ std::string(group), std::string(name), std::string(impl), items, batch, summarize(std::move(samples)) };
+
+            m_log
+                    << std::left << std::setw(32) << (result.group + '/' + result.name)
+                    << std::setw(26) << result.impl
+                    << std::right << std::setw(10) << result.items << " items"
+                    << std::fixed << std::setprecision(2)
+                    << "  median " << std::setw(10) << result.stats.median << " ns"
+                    << "  p10 " << std::setw(10) << result.stats.p10
+                    << "  p90 " << std::setw(10) << result.stats.p90 << '\n'
+                    << std::defaultfloat << std::flush;
+
+            m_results.push_back(std::move(result));
+        }
+
+        // one result per line in the order they ran, so two runs of the same build diff line by line
+        void write_json(std::ostream &os) const
+        {
+            os << std::fixed << std::setprecision(3)
+               << "{\n"
+               << "  \"suite\": \"dna_bench\",\n"
+               << "  \"config\": { "
+               << "\"warmup\": " << m_options.warmup
+               << ", \"repetitions\": " << m_options.repetitions
+               << ", \"min_sample\": " << m_options.min_sample
+               << ", \"filter\": " << json_string(m_options.filter)
+               << ", \"compiler\": " << json_string(compiler())
+               << ", \"optimized\": " << (optimized() ? "true" : "false")
+               << ", \"simd\": " << json_string(simd_level())
+               << " },\n"
+               << "  \"unit\": \"ns/item\",\n"
+               << "  \"results\": [\n";
+
+            for(size_t i = 0; i < m_results.size(); i++)
+            {
+                const Result &r = m_results[i];
+
+                os << "    { \"group\": " << json_string(r.group)
+                   << ", \"name\": " << json_string(r.name)
+                   << ", \"impl\": " << json_string(r.impl)
+                   << ", \"items\": " << r.items
+                   << ", \"batch\": " << r.batch
+                   << ", \"min\": " << r.stats.min
+                   << ", \"p10\": " << r.stats.p10
+                   << ", \"median\": " << r.stats.median
+                   << ", \"p90\": " << r.stats.p90
+                   << ", \"max\": " << r.stats.max
+                   << ", \"mean\": " << r.stats.mean
+                   << ", \"stddev\": " << r.stats.stddev
+                   << " }" << (i + 1 < m_results.size() ? "," : "") << '\n';
+            }
+
+            os << "  ]\n}\n" << std::defaultfloat;
+        }
+
+        [[nodiscard]]
+        const std::vector<Result>& results() const { return m_results; }
+
+    private:
+        std::ostream        &m_log;
+        Options              m_options;
+        std::vector<Result>  m_results;
+
+        // seconds for runs calls of fn
+        template<typename FN>
+        static double time(FN &fn, size_t runs)
+        {
+            using namespace std::chrono;
+
+            clobber_memory();
+
+            auto start = steady_clock::now();
+
+            for(size_t i = 0; i < runs; i++)
+            {
+                fn();
+                clobber_memory();
+            }
+
+            auto end = steady_clock::now();
+
+            return duration_cast<duration<double>>(end - start).count();
+        }
+
+        static std::string compiler()
+        {
+        #if defined(__clang__)
+            return "clang " __clang_version__;
+        #elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+        #else
+            return "unknown";
+        #endif
+        }
+
+        static constexpr bool optimized()
+        {
+        #if defined(__OPTIMIZE__)
+            return true;
+        #else
+            return false;
+        #endif
+        }
+
+        // the kernels pick their instruction set at runtime, so this is what ran and not what the build targets
+        static std::string_view simd_level()
+        {
+            switch(simd::level())
+            {
+                case simd::Level::AVX512: return "avx512";
+                case simd::Level::AVX2:   return "avx2";
+                default:                  return "base";
+            }
+        }
+    };
+}
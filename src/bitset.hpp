@@ -0,0 +1,796 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <bit>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "simd.hpp"
+
+// a dynamically sized array of bits packed into 64 bit words
+// the words start on a cache line and are padded to a whole number of lines so the vectorized set operations
+// never need a scalar tail, bits past size() are always 0 so count and find never have to mask them out
+class Bitset
+{
+public:
+    static constexpr size_t word_bits = 64;
+
+    Bitset() = default;
+
+    explicit Bitset(size_t bits, bool value = false)
+    {
+        resize(bits, value);
+    }
+
+    Bitset(const Bitset &other)
+    {
+        copy_from(other);
+    }
+
+    Bitset(Bitset &&other) noexcept
+    {
+        move_from(std::move(other));
+    }
+
+    ~Bitset()
+    {
+        deallocate(m_words);
+    }
+
+    Bitset& operator=(const Bitset &other)
+    {
+        if(this != &other)
+        {
+            deallocate(m_words);
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    Bitset& operator=(Bitset &&other) noexcept
+    {
+        if(this != &other)
+        {
+            deallocate(m_words);
+            move_from(std::move(other));
+        }
+
+        return *this;
+    }
+
+    // new bits are set to value, bits cut off are gone
+    void resize(size_t bits, bool value = false)
+    {
+        size_t words = padded_words(bits);
+
+        if(words > m_capacity)
+        {
+            uint64_t *temp = allocate(words);
+
+            std::copy_n(m_words, m_capacity, temp);
+            std::fill(temp + m_capacity, temp + words, 0);
+
+            deallocate(m_words);
+
+            m_words    = temp;
+            m_capacity = words;
+        }
+
+        size_t old = m_bits;
+
+        m_bits = bits;
+
+        if(bits > old && value)
+            set_range(old, bits);
+
+        clear_tail();
+    }
+
+    // i has to be below size(), use at for a checked read
+    inline void set(size_t i)
+    {
+        m_words[i / word_bits] |= uint64_t(1) << (i % word_bits);
+    }
+
+    inline void set(size_t i, bool value)
+    {
+        value ? set(i) : reset(i);
+    }
+
+    inline void reset(size_t i)
+    {
+        m_words[i / word_bits] &= ~(uint64_t(1) << (i % word_bits));
+    }
+
+    inline void flip(size_t i)
+    {
+        m_words[i / word_bits] ^= uint64_t(1) << (i % word_bits);
+    }
+
+    [[nodiscard]]
+    inline bool test(size_t i) const
+    {
+        return (m_words[i / word_bits] >> (i % word_bits)) & 1;
+    }
+
+    [[nodiscard]]
+    inline bool operator[](size_t i) const
+    {
+        return test(i);
+    }
+
+    [[nodiscard]]
+    bool at(size_t i) const
+    {
+        if(i >= m_bits)
+            throw std::out_of_range("Bit index is out of range");
+        return test(i);
+    }
+
+    void set_all()
+    {
+        set_range(0, m_bits);
+    }
+
+    void reset_all()
+    {
+        std::fill(m_words, m_words + m_capacity, 0);
+    }
+
+    void flip_all()
+    {
+        for(size_t i = 0; i < m_capacity; i++)
+            m_words[i] = ~m_words[i];
+
+        clear_tail();
+    }
+
+    // sets the bits in [start, end), whole words at a time
+    void set_range(size_t start, size_t end)
+    {
+        if(end > m_bits)
+            end = m_bits;
+
+        for(; start < end && start % word_bits; start++)
+            set(start);
+
+        for(; start + word_bits <= end; start += word_bits)
+            m_words[start / word_bits] = ~uint64_t(0);
+
+        for(; start < end; start++)
+            set(start);
+    }
+
+    // number of set bits
+    [[nodiscard]]
+    size_t count() const
+    {
+        return simd::popcount(m_words, m_capacity);
+    }
+
+    [[nodiscard]]
+    bool any() const
+    {
+        for(size_t i = 0; i < m_capacity; i++)
+        {
+            if(m_words[i])
+                return true;
+        }
+
+        return false;
+    }
+
+    [[nodiscard]]
+    bool none() const { return !any(); }
+
+    [[nodiscard]]
+    bool all() const { return count() == m_bits; }
+
+    // the first set bit at or after from, npos if there is none
+    [[nodiscard]]
+    size_t find_next(size_t from) const
+    {
+        if(from >= m_bits)
+            return npos;
+
+        size_t   index = from / word_bits;
+        uint64_t word  = m_words[index] & (~uint64_t(0) << (from % word_bits));
+
+        while(!word)
+        {
+            if(++index >= m_capacity)
+                return npos;
+
+            word = m_words[index];
+        }
+
+        return index * word_bits + size_t(std::countr_zero(word));
+    }
+
+    [[nodiscard]]
+    size_t find_first() const
+    {
+        return find_next(0);
+    }
+
+    // fn gets the index of every set bit in order, one countr_zero per bit
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        for(size_t i = 0; i < m_capacity; i++)
+        {
+            for(uint64_t word = m_words[i]; word; word &= word - 1)
+                fn(i * word_bits + size_t(std::countr_zero(word)));
+        }
+    }
+
+    // the set operations throw if the sizes differ, they run over whole cache lines of words
+    Bitset& operator&=(const Bitset &other)
+    {
+        check_size(other);
+        simd::bitwise<simd::BitOp::And>(m_words, other.m_words, padded_words(m_bits));
+        return *this;
+    }
+
+    Bitset& operator|=(const Bitset &other)
+    {
+        check_size(other);
+        simd::bitwise<simd::BitOp::Or>(m_words, other.m_words, padded_words(m_bits));
+        return *this;
+    }
+
+    Bitset& operator^=(const Bitset &other)
+    {
+        check_size(other);
+        simd::bitwise<simd::BitOp::Xor>(m_words, other.m_words, padded_words(m_bits));
+        return *this;
+    }
+
+    // clears the bits that are set in other
+    Bitset& and_not(const Bitset &other)
+    {
+        check_size(other);
+        simd::bitwise<simd::BitOp::AndNot>(m_words, other.m_words, padded_words(m_bits));
+        return *this;
+    }
+
+    friend Bitset operator&(Bitset a, const Bitset &b) { return a &= b; }
+
+    friend Bitset operator|(Bitset a, const Bitset &b) { return a |= b; }
+
+    friend Bitset operator^(Bitset a, const Bitset &b) { return a ^= b; }
+
+    friend bool operator==(const Bitset &a, const Bitset &b)
+    {
+        return a.m_bits == b.m_bits && std::equal(a.m_words, a.m_words + a.word_count(), b.m_words);
+    }
+
+    friend bool operator!=(const Bitset &a, const Bitset &b)
+    {
+        return !(a == b);
+    }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_bits; }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_bits == 0; }
+
+    // words in use, the padding after them is 0 as well
+    [[nodiscard]]
+    inline size_t word_count() const { return (m_bits + word_bits - 1) / word_bits; }
+
+    [[nodiscard]]
+    inline const uint64_t* words() const { return m_words; }
+
+    [[nodiscard]]
+    inline size_t bytes() const { return m_capacity * sizeof(uint64_t); }
+
+private:
+    static constexpr size_t line_words = cache_line / sizeof(uint64_t);
+
+    uint64_t *m_words    = nullptr;
+    size_t    m_bits     = 0;
+    size_t    m_capacity = 0;
+
+    static inline size_t padded_words(size_t bits)
+    {
+        size_t words = (bits + word_bits - 1) / word_bits;
+        return (words + line_words - 1) / line_words * line_words;
+    }
+
+    static uint64_t* allocate(size_t words)
+    {
+        return static_cast<uint64_t*>(::operator new(words * sizeof(uint64_t), std::align_val_t(cache_line)));
+    }
+
+    static void deallocate(uint64_t *words)
+    {
+        if(words)
+            ::operator delete(words, std::align_val_t(cache_line));
+    }
+
+    // zeroes every bit from size() on
+    void clear_tail()
+    {
+        size_t used = word_count();
+
+        if(m_bits % word_bits)
+            m_words[used - 1] &= ~uint64_t(0) >> (word_bits - m_bits % word_bits);
+
+        std::fill(m_words + used, m_words + m_capacity, 0);
+    }
+
+    inline void check_size(const Bitset &other) const
+    {
+        if(m_bits != other.m_bits)
+            throw std::invalid_argument("Bitsets differ in size");
+    }
+
+    // this has to be unallocated
+    void copy_from(const Bitset &other)
+    {
+        m_words    = other.m_capacity ? allocate(other.m_capacity) : nullptr;
+        m_bits     = other.m_bits;
+        m_capacity = other.m_capacity;
+
+        std::copy_n(other.m_words, m_capacity, m_words);
+    }
+
+    void move_from(Bitset &&other)
+    {
+        m_words    = other.m_words;
+        m_bits     = other.m_bits;
+        m_capacity = other.m_capacity;
+
+        other.m_words    = nullptr;
+        other.m_bits     = 0;
+        other.m_capacity = 0;
+    }
+};
+
+// a compressed set of 32 bit integers in the roaring layout, values are grouped by their high 16 bits into chunks
+// and a chunk holds its low 16 bits either as a sorted array, while it has at most 4096 of them, or as a 65536 bit map
+// a sparse set costs 2 bytes a value instead of a bit for every possible value, a dense chunk never more than 8KB
+class RoaringBitset
+{
+public:
+
+    RoaringBitset() = default;
+
+    // returns false if value was already there
+    bool add(uint32_t value)
+    {
+        Chunk   &chunk = find_or_add(high(value));
+        uint16_t low   = uint16_t(value);
+
+        if(chunk.is_bitmap())
+        {
+            uint64_t &word = chunk.bitmap[low / 64];
+            uint64_t  bit  = uint64_t(1) << (low % 64);
+
+            if(word & bit)
+                return false;
+
+            word |= bit;
+            chunk.cardinality++;
+            return true;
+        }
+
+        auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+
+        if(it != chunk.array.end() && *it == low)
+            return false;
+
+        chunk.array.insert(it, low);
+        chunk.cardinality++;
+
+        if(chunk.cardinality > array_limit)
+            chunk.to_bitmap();
+
+        return true;
+    }
+
+    // returns true if value was there
+    bool remove(uint32_t value)
+    {
+        size_t index = find(high(value));
+
+        if(index == npos)
+            return false;
+
+        Chunk   &chunk = m_chunks[index];
+        uint16_t low   = uint16_t(value);
+
+        if(chunk.is_bitmap())
+        {
+            uint64_t &word = chunk.bitmap[low / 64];
+            uint64_t  bit  = uint64_t(1) << (low % 64);
+
+            if(!(word & bit))
+                return false;
+
+            word &= ~bit;
+            chunk.cardinality--;
+
+            if(chunk.cardinality <= array_limit)
+                chunk.to_array();
+        }
+        else
+        {
+            auto it = std::lower_bound(chunk.array.begin(), chunk.array.end(), low);
+
+            if(it == chunk.array.end() || *it != low)
+                return false;
+
+            chunk.array.erase(it);
+            chunk.cardinality--;
+        }
+
+        if(chunk.cardinality == 0)
+            m_chunks.erase(m_chunks.begin() + index);
+
+        return true;
+    }
+
+    [[nodiscard]]
+    bool contains(uint32_t value) const
+    {
+        size_t index = find(high(value));
+
+        if(index == npos)
+            return false;
+
+        const Chunk &chunk = m_chunks[index];
+        uint16_t     low   = uint16_t(value);
+
+        if(chunk.is_bitmap())
+            return (chunk.bitmap[low / 64] >> (low % 64)) & 1;
+
+        return std::binary_search(chunk.array.begin(), chunk.array.end(), low);
+    }
+
+    // number of values in the set
+    [[nodiscard]]
+    size_t size() const
+    {
+        size_t total = 0;
+
+        for(auto &chunk : m_chunks)
+            total += chunk.cardinality;
+
+        return total;
+    }
+
+    [[nodiscard]]
+    bool empty() const { return m_chunks.empty(); }
+
+    void clear() { m_chunks.clear(); }
+
+    // fn gets every value in ascending order
+    template<typename FN>
+    void for_each(FN fn) const
+    {
+        for(auto &chunk : m_chunks)
+        {
+            uint32_t base = uint32_t(chunk.key) << 16;
+
+            if(!chunk.is_bitmap())
+            {
+                for(uint16_t low : chunk.array)
+                    fn(base | low);
+                continue;
+            }
+
+            for(size_t i = 0; i < bitmap_words; i++)
+            {
+                for(uint64_t word = chunk.bitmap[i]; word; word &= word - 1)
+                    fn(base | uint32_t(i * 64 + size_t(std::countr_zero(word))));
+            }
+        }
+    }
+
+    RoaringBitset& operator|=(const RoaringBitset &other)
+    {
+        std::vector<Chunk> merged;
+        merged.reserve(m_chunks.size() + other.m_chunks.size());
+
+        size_t i = 0, j = 0;
+
+        while(i < m_chunks.size() || j < other.m_chunks.size())
+        {
+            if(j == other.m_chunks.size() || (i < m_chunks.size() && m_chunks[i].key < other.m_chunks[j].key))
+            {
+                merged.push_back(std::move(m_chunks[i++]));
+            }
+            else if(i == m_chunks.size() || other.m_chunks[j].key < m_chunks[i].key)
+            {
+                merged.push_back(other.m_chunks[j++]);
+            }
+            else
+            {
+                merged.push_back(unite(std::move(m_chunks[i++]), other.m_chunks[j++]));
+            }
+        }
+
+        m_chunks = std::move(merged);
+
+        return *this;
+    }
+
+    RoaringBitset& operator&=(const RoaringBitset &other)
+    {
+        std::vector<Chunk> kept;
+
+        size_t i = 0, j = 0;
+
+        while(i < m_chunks.size() && j < other.m_chunks.size())
+        {
+            if(m_chunks[i].key < other.m_chunks[j].key)
+            {
+                i++;
+            }
+            else if(other.m_chunks[j].key < m_chunks[i].key)
+            {
+                j++;
+            }
+            else
+            {
+                Chunk chunk = intersect(std::move(m_chunks[i++]), other.m_chunks[j++]);
+
+                if(chunk.cardinality)
+                    kept.push_back(std::move(chunk));
+            }
+        }
+
+        m_chunks = std::move(kept);
+
+        return *this;
+    }
+
+    friend RoaringBitset operator|(RoaringBitset a, const RoaringBitset &b) { return a |= b; }
+
+    friend RoaringBitset operator&(RoaringBitset a, const RoaringBitset &b) { return a &= b; }
+
+    // memory held by the chunks, not counting the chunk list itself
+    [[nodiscard]]
+    size_t bytes() const
+    {
+        size_t total = 0;
+
+        for(auto &chunk : m_chunks)
+            total += chunk.is_bitmap() ? bitmap_words * sizeof(uint64_t) : chunk.array.capacity() * sizeof(uint16_t);
+
+        return total;
+    }
+
+private:
+    static constexpr size_t array_limit  = 4096;
+    static constexpr size_t bitmap_words = 65536 / 64;
+
+    struct Chunk
+    {
+        uint16_t              key         = 0;
+        uint32_t              cardinality = 0;
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bitmap;
+
+        bool is_bitmap() const { return !bitmap.empty(); }
+
+        void to_bitmap()
+        {
+            bitmap.assign(bitmap_words, 0);
+
+            for(uint16_t low : array)
+                bitmap[low / 64] |= uint64_t(1) << (low % 64);
+
+            array.clear();
+            array.shrink_to_fit();
+        }
+
+        void to_array()
+        {
+            array.clear();
+            array.reserve(cardinality);
+
+            for(size_t i = 0; i < bitmap_words; i++)
+            {
+                for(uint64_t word = bitmap[i]; word; word &= word - 1)
+                    array.push_back(uint16_t(i * 64 + size_t(std::countr_zero(word))));
+            }
+
+            bitmap.clear();
+            bitmap.shrink_to_fit();
+        }
+    };
+
+    // sorted by key
+    std::vector<Chunk> m_chunks;
+
+    static inline uint16_t high(uint32_t value) { return uint16_t(value >> 16); }
+
+    size_t find(uint16_t key) const
+    {
+        auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key, [](const Chunk &c, uint16_t k) { return c.key < k; });
+
+        return it != m_chunks.end() && it->key == key ? size_t(it - m_chunks.begin()) : npos;
+    }
+
+    Chunk& find_or_add(uint16_t key)
+    {
+        auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key, [](const Chunk &c, uint16_t k) { return c.key < k; });
+
+        if(it != m_chunks.end() && it->key == key)
+            return *it;
+
+        Chunk chunk;
+        chunk.key = key;
+
+        return *m_chunks.insert(it, std::move(chunk));
+    }
+
+    static Chunk unite(Chunk a, const Chunk &b)
+    {
+        if(!a.is_bitmap() && !b.is_bitmap())
+        {
+            std::vector<uint16_t> merged;
+            merged.reserve(a.array.size() + b.array.size());
+
+            std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(merged));
+
+            a.array       = std::move(merged);
+            a.cardinality = uint32_t(a.array.size());
+
+            if(a.cardinality > array_limit)
+                a.to_bitmap();
+
+            return a;
+        }
+
+        if(!a.is_bitmap())
+            a.to_bitmap();
+
+        if(b.is_bitmap())
+        {
+            simd::bitwise<simd::BitOp::Or>(a.bitmap.data(), b.bitmap.data(), bitmap_words);
+        }
+        else
+        {
+            for(uint16_t low : b.array)
+                a.bitmap[low / 64] |= uint64_t(1) << (low % 64);
+        }
+
+        a.cardinality = uint32_t(simd::popcount(a.bitmap.data(), bitmap_words));
+
+        return a;
+    }
+
+    static Chunk intersect(Chunk a, const Chunk &b)
+    {
+        if(a.is_bitmap() && b.is_bitmap())
+        {
+            simd::bitwise<simd::BitOp::And>(a.bitmap.data(), b.bitmap.data(), bitmap_words);
+
+            a.cardinality = uint32_t(simd::popcount(a.bitmap.data(), bitmap_words));
+
+            if(a.cardinality <= array_limit)
+                a.to_array();
+
+            return a;
+        }
+
+        // the array side decides, every value of it is looked up in the other chunk
+        const Chunk &array = a.is_bitmap() ? b : a;
+        const Chunk &other = a.is_bitmap() ? a : b;
+
+        std::vector<uint16_t> kept;
+        kept.reserve(array.array.size());
+
+        if(other.is_bitmap())
+        {
+            for(uint16_t low : array.array)
+            {
+                if((other.bitmap[low / 64] >> (low % 64)) & 1)
+                    kept.push_back(low);
+            }
+        }
+        else
+        {
+            std::set_intersection(array.array.begin(), array.array.end(), other.array.begin(), other.array.end(), std::back_inserter(kept));
+        }
+
+        Chunk output;
+        output.key         = a.key;
+        output.cardinality = uint32_t(kept.size());
+        output.array       = std::move(kept);
+
+        return output;
+    }
+};
+
+// Bitset against std::vector<bool> on filling, counting, intersecting and walking the set bits,
+// then a sparse set stored as a RoaringBitset against a Bitset over the whole range
+void bitset_bench(const size_t bits = 1 << 26)
+{
+    using namespace std::chrono;
+
+    auto time = [](auto fn)
+    {
+        auto start = steady_clock::now();
+
+        volatile auto result = fn();
+        (void)result;
+
+        return duration_cast<duration<double>>(steady_clock::now() - start).count() * 1e3;
+    };
+
+    std::vector<bool> va(bits), vb(bits);
+    Bitset            ba(bits), bb(bits);
+
+    double vector_fill = time([&] { for(size_t i = 0; i < bits; i += 3) va[i] = true; return va.size(); });
+    double bitset_fill = time([&] { for(size_t i = 0; i < bits; i += 3) ba.set(i); return ba.size(); });
+
+    for(size_t i = 0; i < bits; i += 5)
+    {
+        vb[i] = true;
+        bb.set(i);
+    }
+
+    double vector_count = time([&] { return std::count(va.begin(), va.end(), true); });
+    double bitset_count = time([&] { return ba.count(); });
+
+    double vector_and = time([&] { for(size_t i = 0; i < bits; i++) va[i] = va[i] && vb[i]; return va.size(); });
+    double bitset_and = time([&] { ba &= bb; return ba.size(); });
+
+    double vector_walk = time([&] { size_t total = 0; for(size_t i = 0; i < bits; i++) if(va[i]) total += i; return total; });
+    double bitset_walk = time([&] { size_t total = 0; for(size_t i = ba.find_first(); i != npos; i = ba.find_next(i + 1)) total += i; return total; });
+
+    bool same = size_t(std::count(va.begin(), va.end(), true)) == ba.count();
+
+    std::cout
+            << bits << " bits, ms for vector<bool> / Bitset" << (same ? "" : " MISMATCH") << '\n'
+            << "  set every 3rd: " << vector_fill << " / " << bitset_fill << '\n'
+            << "  count:         " << vector_count << " / " << bitset_count << '\n'
+            << "  and:           " << vector_and << " / " << bitset_and << '\n'
+            << "  walk set bits: " << vector_walk << " / " << bitset_walk << '\n';
+
+    // one value in about a thousand across a 2^28 range
+    const size_t range  = size_t(1) << 28;
+    const size_t values = range >> 10;
+
+    RoaringBitset ra, rb;
+    Bitset        full(range);
+
+    for(size_t i = 0; i < values; i++)
+    {
+        uint32_t value = uint32_t(size_t(uint32_t(rand()) * 2654435761u) & (range - 1));
+
+        ra.add(value);
+        full.set(value);
+
+        if(i % 2)
+            rb.add(value ^ 1);
+    }
+
+    const uint32_t probes = 1 << 24;
+
+    double roaring_contains = time([&] { size_t found = 0; for(uint32_t v = 0; v < probes; v++) found += ra.contains((v * 257) & (range - 1)); return found; });
+    double bitset_contains  = time([&] { size_t found = 0; for(uint32_t v = 0; v < probes; v++) found += full.test((v * 257) & (range - 1)); return found; });
+
+    double roaring_union = time([&] { return (ra | rb).size(); });
+
+    std::cout
+            << ra.size() << " sparse values out of " << range << '\n'
+            << "  memory:           " << ra.bytes() / 1024 << " KB roaring / " << full.bytes() / 1024 << " KB bitset\n"
+            << "  " << probes << " contains, ms: " << roaring_contains << " roaring / " << bitset_contains << " bitset\n"
+            << "  union, ms:        " << roaring_union << " roaring\n";
+}
@@ -35,7 +35,7 @@ public:
     BST(std::initializer_list<Pair> items)
     {
         for (auto &[key, value]: items)
-            insert(key, std::forward<V>(value));
+            insert(key, value);
     }
 
     ~BST()
@@ -64,9 +64,9 @@ public:
     {
         Node *node = m_root;
 
-        while (node && item != node->item)
+        while (node && item != node->key)
         {
-            if (item < node->item)
+            if (item < node->key)
                 node = node->left;
             else
                 node = node->right;
@@ -106,12 +106,12 @@ public:
 
     inline V& min() const
     {
-        return min_node()->item;
+        return min_node()->value;
     }
 
     inline V& max() const
     {
-        return max_node()->item;
+        return max_node()->value;
     }
 
     void erase(Node *node)
@@ -176,7 +176,7 @@ private:
 
         foreach_node(node->left, fn);
 
-        fn(node->item);
+        fn(node->key, node->value);
 
         foreach_node(node->right, fn);
     }
@@ -203,7 +203,7 @@ private:
         {
             p = x;
 
-            if (node->item < x->item)
+            if (node->key < x->key)
                 x = x->left;
             else
                 x = x->right;
@@ -213,7 +213,7 @@ private:
 
         if (!p)
             m_root = node;
-        else if (node->item < p->item)
+        else if (node->key < p->key)
             p->left = node;
         else
             p->right = node;
@@ -1,25 +1,40 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
 #include "util.hpp"
+#include "simd.hpp"
+
+// containers laid out as one array of numbers, the algorithms below run vectorized kernels on them
+template<typename C>
+concept is_contiguous_arithmetic = is_container<C> && requires(const C& c)
+{
+    { c.begin() } -> std::contiguous_iterator;
+    requires simd::is_vectorizable<std::iter_value_t<decltype(c.begin())>>;
+};
 
 namespace container
 {
     template<is_container C, typename FN>
-    void map(C& container, FN fn)
+    constexpr void map(C& container, FN fn)
     {
         for(auto& item : container)
             item = fn(item);
     }
 
     template<is_container C, typename FN>
-    void each(C& container, FN fn)
+    constexpr void each(C& container, FN fn)
     {
         for(auto& item : container)
             fn(item);
     }
 
     template<is_container C, typename FN>
-    void reduce(C& container, FN fn)
+    constexpr void reduce(C& container, FN fn)
     {
         auto previous = *container.begin();
 
@@ -28,7 +43,7 @@ namespace container
     }
 
     template<is_container C>
-    auto sum(const C& container)
+    constexpr auto sum(const C& container)
     {
         auto total = *container.begin();
 
@@ -38,8 +53,69 @@ namespace container
         return total;
     }
 
+    template<is_contiguous_arithmetic C>
+    constexpr auto sum(const C& container)
+    {
+        return simd::sum(std::to_address(container.begin()), size_t(container.end() - container.begin()));
+    }
+
+    // throws if the container is empty
+    template<is_container C>
+    constexpr auto minmax(const C& container)
+    {
+        if(container.empty())
+            throw std::out_of_range("Container is empty");
+
+        auto low  = *container.begin();
+        auto high = low;
+
+        for(auto &item : container)
+        {
+            if(item < low)
+                low = item;
+
+            if(high < item)
+                high = item;
+        }
+
+        return std::pair(low, high);
+    }
+
+    template<is_contiguous_arithmetic C>
+    constexpr auto minmax(const C& container)
+    {
+        if(container.empty())
+            throw std::out_of_range("Container is empty");
+
+        return simd::minmax(std::to_address(container.begin()), size_t(container.end() - container.begin()));
+    }
+
+    template<is_container C>
+    constexpr auto min(const C& container)
+    {
+        return minmax(container).first;
+    }
+
+    template<is_container C>
+    constexpr auto max(const C& container)
+    {
+        return minmax(container).second;
+    }
+
+    // how many items equal item
+    template<is_container C, typename T>
+    constexpr size_t count(const C& container, const T& item)
+    {
+        size_t found = 0;
+
+        for(auto &i : container)
+            found += i == item;
+
+        return found;
+    }
+
     template<is_container C, typename FN>
-    bool every(C& container, FN fn)
+    constexpr bool every(C& container, FN fn)
     {
         for(auto &item : container)
         {
@@ -51,7 +127,7 @@ namespace container
     }
 
     template<is_container C, typename T>
-    bool includes(C& container, const T& item)
+    constexpr bool includes(const C& container, const T& item)
     {
         for(auto &i : container)
         {
@@ -63,7 +139,7 @@ namespace container
     }
 
     template<is_container C, typename T>
-    void fill(C& container, size_t start, size_t end, const T& item)
+    constexpr void fill(C& container, size_t start, size_t end, const T& item)
     {
         if(start >= container.size() || end >= container.size())
             return;
@@ -74,16 +150,69 @@ namespace container
         }
     }
 
+    // walks the iterators rather than operator[] so there is no bounds check per item, npos if item is not there
     template<is_container C, typename T>
-    size_t index_of(C& container, const T& item, size_t offset = 0)
+    constexpr size_t index_of(const C& container, const T& item, size_t offset = 0)
     {
-        for(size_t i = offset; i < container.size(); i++)
+        auto current = container.begin();
+        auto last    = container.end();
+
+        if constexpr(std::random_access_iterator<decltype(current)>)
         {
-            if(container[i] == item)
+            if(offset >= size_t(last - current))
+                return npos;
+
+            current += offset;
+        }
+        else
+        {
+            for(size_t i = 0; i < offset && current != last; i++)
+                ++current;
+        }
+
+        for(size_t i = offset; current != last; ++current, i++)
+        {
+            if(*current == item)
                 return i;
         }
 
-        return -1;
+        return npos;
+    }
+
+    // the item is converted to the element type first, if that changes its value nothing can be equal to it
+    template<is_contiguous_arithmetic C, typename T>
+        requires std::is_arithmetic_v<T>
+    constexpr size_t index_of(const C& container, const T& item, size_t offset = 0)
+    {
+        using E = std::iter_value_t<decltype(container.begin())>;
+
+        size_t size = size_t(container.end() - container.begin());
+
+        if(offset >= size || E(item) != item)
+            return npos;
+
+        size_t found = simd::index_of(std::to_address(container.begin()) + offset, size - offset, E(item));
+
+        return found == npos ? npos : found + offset;
+    }
+
+    template<is_contiguous_arithmetic C, typename T>
+        requires std::is_arithmetic_v<T>
+    constexpr bool includes(const C& container, const T& item)
+    {
+        return index_of(container, item) != npos;
+    }
+
+    template<is_contiguous_arithmetic C, typename T>
+        requires std::is_arithmetic_v<T>
+    constexpr size_t count(const C& container, const T& item)
+    {
+        using E = std::iter_value_t<decltype(container.begin())>;
+
+        if(E(item) != item)
+            return 0;
+
+        return simd::count(std::to_address(container.begin()), size_t(container.end() - container.begin()), E(item));
     }
 }
 
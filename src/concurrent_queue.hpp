@@ -0,0 +1,444 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+
+#include "util.hpp"
+
+// bounded lock-free queues on a ring buffer
+// the capacity is rounded up to a power of two and enqueue fails instead of growing when the ring is full,
+// the indices sit on their own cache lines (alignas pads the class out) so the two ends never false share
+
+// multi producer multi consumer queue, Dmitry Vyukov's design
+// every slot carries a sequence number that says which lap of the ring it is ready for,
+// so producers and consumers only contend on their own end and hand slots over without locks
+template<class T>
+class MPMCQueue
+{
+public:
+
+    explicit MPMCQueue(size_t capacity)
+    {
+        m_capacity = std::bit_ceil(capacity < 2 ? 2 : capacity);
+        m_mask     = m_capacity - 1;
+        m_cells    = std::make_unique<Cell[]>(m_capacity);
+
+        for(size_t i = 0; i < m_capacity; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    // returns false when the queue is full
+    bool enqueue(T item)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell  *cell;
+
+        while(true)
+        {
+            cell = &m_cells[pos & m_mask];
+
+            size_t   sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff     = intptr_t(sequence) - intptr_t(pos);
+
+            if(diff == 0)
+            {
+                if(m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // returns false when the queue is empty
+    bool dequeue(T &item)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Cell  *cell;
+
+        while(true)
+        {
+            cell = &m_cells[pos & m_mask];
+
+            size_t   sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff     = intptr_t(sequence) - intptr_t(pos + 1);
+
+            if(diff == 0)
+            {
+                if(m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = std::move(cell->data);
+        cell->sequence.store(pos + m_capacity, std::memory_order_release);
+
+        return true;
+    }
+
+    // claims a run of free slots with a single CAS, returns how many items were enqueued
+    size_t enqueue_bulk(const T *items, size_t count)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        size_t run;
+
+        while(true)
+        {
+            run = 0;
+
+            while(run < count && run < m_capacity)
+            {
+                size_t sequence = m_cells[(pos + run) & m_mask].sequence.load(std::memory_order_acquire);
+
+                if(sequence != pos + run)
+                    break;
+
+                run++;
+            }
+
+            if(run == 0)
+            {
+                // another producer may have moved past pos in the meantime
+                size_t current = m_tail.load(std::memory_order_relaxed);
+
+                if(current == pos)
+                    return 0;
+
+                pos = current;
+                continue;
+            }
+
+            if(m_tail.compare_exchange_weak(pos, pos + run, std::memory_order_relaxed))
+                break;
+        }
+
+        for(size_t i = 0; i < run; i++)
+        {
+            Cell &cell = m_cells[(pos + i) & m_mask];
+
+            cell.data = items[i];
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+
+        return run;
+    }
+
+    // claims a run of filled slots with a single CAS, returns how many items were dequeued
+    size_t dequeue_bulk(T *items, size_t max)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        size_t run;
+
+        while(true)
+        {
+            run = 0;
+
+            while(run < max && run < m_capacity)
+            {
+                size_t sequence = m_cells[(pos + run) & m_mask].sequence.load(std::memory_order_acquire);
+
+                if(sequence != pos + run + 1)
+                    break;
+
+                run++;
+            }
+
+            if(run == 0)
+            {
+                size_t current = m_head.load(std::memory_order_relaxed);
+
+                if(current == pos)
+                    return 0;
+
+                pos = current;
+                continue;
+            }
+
+            if(m_head.compare_exchange_weak(pos, pos + run, std::memory_order_relaxed))
+                break;
+        }
+
+        for(size_t i = 0; i < run; i++)
+        {
+            Cell &cell = m_cells[(pos + i) & m_mask];
+
+            items[i] = std::move(cell.data);
+            cell.sequence.store(pos + i + m_capacity, std::memory_order_release);
+        }
+
+        return run;
+    }
+
+    // only a snapshot while other threads are running
+    [[nodiscard]]
+    size_t size() const
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        return tail > head ? tail - head : 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const { return size() == 0; }
+
+    [[nodiscard]]
+    size_t capacity() const { return m_capacity; }
+
+private:
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    size_t                  m_capacity;
+    size_t                  m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(cache_line) std::atomic<size_t> m_head{0};
+    alignas(cache_line) std::atomic<size_t> m_tail{0};
+};
+
+// single producer single consumer queue
+// only one thread writes each index so there is no CAS, each side caches the other's index
+// and only reloads it when the ring looks full or empty
+template<class T>
+class SPSCQueue
+{
+public:
+
+    explicit SPSCQueue(size_t capacity)
+    {
+        m_capacity = std::bit_ceil(capacity < 2 ? 2 : capacity);
+        m_mask     = m_capacity - 1;
+        m_data     = std::make_unique<T[]>(m_capacity);
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    bool enqueue(T item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if(tail - m_head_cache == m_capacity)
+        {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+
+            if(tail - m_head_cache == m_capacity)
+                return false;
+        }
+
+        m_data[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool dequeue(T &item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if(head == m_tail_cache)
+        {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+            if(head == m_tail_cache)
+                return false;
+        }
+
+        item = std::move(m_data[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t enqueue_bulk(const T *items, size_t count)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if(m_capacity - (tail - m_head_cache) < count)
+            m_head_cache = m_head.load(std::memory_order_acquire);
+
+        size_t run = std::min(count, m_capacity - (tail - m_head_cache));
+
+        for(size_t i = 0; i < run; i++)
+            m_data[(tail + i) & m_mask] = items[i];
+
+        m_tail.store(tail + run, std::memory_order_release);
+
+        return run;
+    }
+
+    size_t dequeue_bulk(T *items, size_t max)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if(m_tail_cache - head < max)
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+        size_t run = std::min(max, m_tail_cache - head);
+
+        for(size_t i = 0; i < run; i++)
+            items[i] = std::move(m_data[(head + i) & m_mask]);
+
+        m_head.store(head + run, std::memory_order_release);
+
+        return run;
+    }
+
+    [[nodiscard]]
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]]
+    bool empty() const { return size() == 0; }
+
+    [[nodiscard]]
+    size_t capacity() const { return m_capacity; }
+
+private:
+    size_t               m_capacity;
+    size_t               m_mask;
+    std::unique_ptr<T[]> m_data;
+
+    // the consumer's line
+    alignas(cache_line) std::atomic<size_t> m_head{0};
+    size_t m_tail_cache = 0;
+
+    // the producer's line
+    alignas(cache_line) std::atomic<size_t> m_tail{0};
+    size_t m_head_cache = 0;
+};
+
+// throughput and enqueue to dequeue latency for each producer/consumer ratio
+template<class Q>
+void concurrent_queue_bench(const char *name, size_t producers, size_t consumers, size_t items)
+{
+    using namespace std::chrono;
+
+    Q queue(1024);
+
+    const size_t per_producer = items / producers;
+    const size_t total        = per_producer * producers;
+
+    std::atomic<size_t> consumed{0};
+    std::atomic<bool>   go{false};
+
+    std::vector<std::vector<int64_t>> latencies(consumers);
+    std::vector<std::thread>          threads;
+
+    auto now = []
+    {
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    };
+
+    for(size_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&]
+        {
+            while(!go.load(std::memory_order_acquire));
+
+            for(size_t i = 0; i < per_producer; i++)
+            {
+                while(!queue.enqueue(now()))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    for(size_t c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&, c]
+        {
+            auto &samples = latencies[c];
+            int64_t stamp;
+
+            samples.reserve(total / consumers + 1);
+
+            while(!go.load(std::memory_order_acquire));
+
+            while(consumed.load(std::memory_order_relaxed) < total)
+            {
+                if(!queue.dequeue(stamp))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                samples.push_back(now() - stamp);
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    auto start = steady_clock::now();
+
+    go.store(true, std::memory_order_release);
+
+    for(auto &thread : threads)
+        thread.join();
+
+    auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    std::vector<int64_t> all;
+
+    for(auto &samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+
+    std::sort(all.begin(), all.end());
+
+    auto percentile = [&](double p) { return all.empty() ? 0 : all[size_t(p * double(all.size() - 1))]; };
+
+    std::cout
+            << name << ' ' << producers << "P/" << consumers << "C: "
+            << size_t(double(total) / elapsed) << " ops/s, latency"
+            << " p50 " << percentile(0.5) << "ns"
+            << " p99 " << percentile(0.99) << "ns"
+            << " p99.9 " << percentile(0.999) << "ns\n";
+}
+
+void concurrent_queue_bench(const size_t items)
+{
+    const std::pair<size_t, size_t> ratios[] = { {1, 1}, {1, 4}, {4, 1}, {2, 2}, {4, 4} };
+
+    concurrent_queue_bench<SPSCQueue<int64_t>>("spsc", 1, 1, items);
+
+    for(auto [producers, consumers] : ratios)
+        concurrent_queue_bench<MPMCQueue<int64_t>>("mpmc", producers, consumers, items);
+}
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+
+#include "concurrent_queue.hpp"
+#include "stack.hpp"
+
+// hazard pointers, a thread publishes the node it is about to read and retired nodes are only freed
+// once no thread has them published, so a node can never be freed or reused under a reader and a CAS on it can't ABA
+// one domain is shared by every structure, each thread claims a record the first time it needs one
+class HazardDomain
+{
+public:
+
+    static constexpr size_t max_threads = 256;
+
+    HazardDomain() = default;
+
+    HazardDomain(const HazardDomain&) = delete;
+    HazardDomain& operator=(const HazardDomain&) = delete;
+
+    ~HazardDomain()
+    {
+        for(auto &record : m_records)
+        {
+            for(auto &retired : record.retired)
+                retired.deleter(retired.pointer);
+        }
+    }
+
+    static HazardDomain& global()
+    {
+        static HazardDomain domain;
+        return domain;
+    }
+
+    // publishes the pointer for the calling thread, nullptr clears it
+    void protect(const void *pointer)
+    {
+        record().hazard.store(pointer, std::memory_order_seq_cst);
+    }
+
+    void clear()
+    {
+        record().hazard.store(nullptr, std::memory_order_release);
+    }
+
+    // hands the node over to be freed once nobody protects it
+    template<typename T>
+    void retire(T *pointer)
+    {
+        Record &own = record();
+
+        own.retired.push_back({ pointer, [](void *p) { delete static_cast<T*>(p); } });
+
+        if(own.retired.size() >= 2 * m_high.load(std::memory_order_relaxed) + 64)
+            scan(own);
+    }
+
+private:
+
+    struct Retired
+    {
+        void  *pointer;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(cache_line) Record
+    {
+        std::atomic<const void*> hazard{nullptr};
+        std::atomic<bool>        active{false};
+        // only touched by the owning thread, a record that is claimed again inherits what is left
+        std::vector<Retired>     retired;
+    };
+
+    // gives the record back when the thread exits
+    struct Owner
+    {
+        Record *record = nullptr;
+
+        ~Owner()
+        {
+            if(!record)
+                return;
+
+            record->hazard.store(nullptr, std::memory_order_release);
+            record->active.store(false, std::memory_order_release);
+        }
+    };
+
+    Record              m_records[max_threads];
+    std::atomic<size_t> m_high{0};
+
+    Record& record()
+    {
+        static thread_local Owner owner;
+
+        if(!owner.record)
+            owner.record = &claim();
+
+        return *owner.record;
+    }
+
+    Record& claim()
+    {
+        size_t high = std::min(m_high.load(std::memory_order_acquire), max_threads);
+
+        for(size_t i = 0; i < high; i++)
+        {
+            bool expected = false;
+
+            if(m_records[i].active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return m_records[i];
+        }
+
+        // m_high never goes past max_threads, a thread that finds no room throws without moving it
+        size_t index = m_high.load(std::memory_order_relaxed);
+
+        do
+        {
+            if(index >= max_threads)
+                throw std::out_of_range("Too many threads for the hazard domain");
+        }
+        while(!m_high.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        m_records[index].active.store(true, std::memory_order_release);
+
+        return m_records[index];
+    }
+
+    void scan(Record &own)
+    {
+        std::vector<const void*> hazards;
+
+        size_t high = std::min(m_high.load(std::memory_order_acquire), max_threads);
+
+        for(size_t i = 0; i < high; i++)
+        {
+            const void *hazard = m_records[i].hazard.load(std::memory_order_seq_cst);
+
+            if(hazard)
+                hazards.push_back(hazard);
+        }
+
+        std::sort(hazards.begin(), hazards.end());
+
+        size_t kept = 0;
+
+        for(auto &retired : own.retired)
+        {
+            if(std::binary_search(hazards.begin(), hazards.end(), retired.pointer))
+                own.retired[kept++] = retired;
+            else
+                retired.deleter(retired.pointer);
+        }
+
+        own.retired.resize(kept);
+    }
+};
+
+// lock-free LIFO, Treiber's stack with hazard pointer reclamation
+// under contention a failed CAS on top falls back to an elimination array where a push and a pop
+// meet in a random slot and cancel out without touching top at all
+template<class T>
+class ConcurrentStack
+{
+public:
+
+    explicit ConcurrentStack(bool elimination = true) : m_elimination(elimination) {}
+
+    ConcurrentStack(const ConcurrentStack&) = delete;
+    ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+    // only safe once every other thread is done with the stack
+    ~ConcurrentStack()
+    {
+        Node *node = m_top.load(std::memory_order_relaxed);
+
+        while(node)
+        {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    void push(T item)
+    {
+        Node *node = new Node(std::move(item));
+        Node *top  = m_top.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            node->next = top;
+
+            if(m_top.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed))
+                break;
+
+            if(m_elimination && offer(node))
+                break;
+
+            top = m_top.load(std::memory_order_relaxed);
+        }
+
+        m_size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // returns false when the stack is empty
+    bool try_pop(T &item)
+    {
+        auto &hazards = HazardDomain::global();
+        Node *node;
+
+        while(true)
+        {
+            node = m_top.load(std::memory_order_acquire);
+
+            if(!node)
+            {
+                hazards.clear();
+                return false;
+            }
+
+            hazards.protect(node);
+
+            // top may have been popped and freed before the hazard was visible
+            if(m_top.load(std::memory_order_seq_cst) != node)
+                continue;
+
+            if(m_top.compare_exchange_strong(node, node->next, std::memory_order_acquire, std::memory_order_relaxed))
+                break;
+
+            if(m_elimination && (node = take_offer()))
+                break;
+        }
+
+        hazards.clear();
+
+        // copied rather than moved, a peek may still be reading it
+        item = node->value;
+
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        hazards.retire(node);
+
+        return true;
+    }
+
+    // copies the top item, returns false when the stack is empty
+    bool peek(T &item) const
+    {
+        auto &hazards = HazardDomain::global();
+        Node *node;
+
+        do
+        {
+            node = m_top.load(std::memory_order_acquire);
+
+            if(!node)
+            {
+                hazards.clear();
+                return false;
+            }
+
+            hazards.protect(node);
+        }
+        while(m_top.load(std::memory_order_seq_cst) != node);
+
+        item = node->value;
+
+        hazards.clear();
+
+        return true;
+    }
+
+    // Stack's peek, throws when the stack is empty
+    [[nodiscard]]
+    T peek() const
+    {
+        T item;
+
+        if(!peek(item))
+            throw std::out_of_range("Stack is empty");
+
+        return item;
+    }
+
+    // only a snapshot while other threads are running
+    [[nodiscard]]
+    size_t size() const
+    {
+        int64_t size = m_size.load(std::memory_order_relaxed);
+        return size > 0 ? size : 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const { return m_top.load(std::memory_order_acquire) == nullptr; }
+
+private:
+
+    struct Node
+    {
+        T     value;
+        Node *next = nullptr;
+
+        explicit Node(T value) : value(std::move(value)) {}
+    };
+
+    static constexpr size_t elimination_slots = 16;
+    static constexpr size_t elimination_spins = 128;
+
+    struct alignas(cache_line) Slot
+    {
+        std::atomic<Node*> node{nullptr};
+    };
+
+    alignas(cache_line) std::atomic<Node*>   m_top{nullptr};
+    alignas(cache_line) std::atomic<int64_t> m_size{0};
+
+    Slot m_slots[elimination_slots];
+    bool m_elimination;
+
+    static size_t random_slot()
+    {
+        static thread_local uint32_t state = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state % elimination_slots;
+    }
+
+    // parks the node in a slot for a while, returns true if a pop took it
+    // the node stays protected while it is offered so a pop can't free it and hand the address to another offer,
+    // which would let the withdrawing CAS below succeed on someone else's node
+    bool offer(Node *node)
+    {
+        auto &hazards = HazardDomain::global();
+        Slot &slot    = m_slots[random_slot()];
+        Node *empty   = nullptr;
+
+        hazards.protect(node);
+
+        if(!slot.node.compare_exchange_strong(empty, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+            hazards.clear();
+            return false;
+        }
+
+        for(size_t i = 0; i < elimination_spins; i++)
+        {
+            if(slot.node.load(std::memory_order_relaxed) != node)
+                break;
+        }
+
+        Node *expected = node;
+        bool  taken    = !slot.node.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+
+        hazards.clear();
+
+        return taken;
+    }
+
+    Node* take_offer()
+    {
+        Slot &slot = m_slots[random_slot()];
+        Node *node = slot.node.load(std::memory_order_acquire);
+
+        if(node && slot.node.compare_exchange_strong(node, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+            return node;
+
+        return nullptr;
+    }
+};
+
+// hammers the stack from every thread and checks the history could have come from a sequential stack,
+// every value comes out exactly once and whatever is left at the end is in the order each thread pushed it
+bool concurrent_stack_check(size_t threads, size_t operations)
+{
+    ConcurrentStack<uint64_t> stack;
+
+    std::vector<std::vector<uint64_t>> popped(threads);
+    std::vector<std::thread>           workers;
+    std::atomic<bool>                  go{false};
+
+    // values are thread << 32 | sequence
+    for(size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]
+        {
+            uint64_t next = 0;
+            uint64_t item;
+
+            while(!go.load(std::memory_order_acquire));
+
+            for(size_t i = 0; i < operations; i++)
+            {
+                if(i % 3 != 2)
+                    stack.push(uint64_t(t) << 32 | next++);
+                else if(stack.try_pop(item))
+                    popped[t].push_back(item);
+            }
+        });
+    }
+
+    go.store(true, std::memory_order_release);
+
+    for(auto &worker : workers)
+        worker.join();
+
+    std::vector<uint64_t> rest;
+    uint64_t item;
+
+    while(stack.try_pop(item))
+        rest.push_back(item);
+
+    std::vector<int64_t> last(threads, INT64_MAX);
+
+    for(uint64_t value : rest)
+    {
+        size_t  t        = value >> 32;
+        int64_t sequence = int64_t(value & 0xffffffff);
+
+        if(sequence >= last[t])
+            return false;
+
+        last[t] = sequence;
+    }
+
+    std::vector<uint64_t> all = rest;
+
+    for(auto &values : popped)
+        all.insert(all.end(), values.begin(), values.end());
+
+    std::sort(all.begin(), all.end());
+
+    if(std::adjacent_find(all.begin(), all.end()) != all.end())
+        return false;
+
+    size_t pushed = 0;
+
+    for(size_t i = 0; i < operations; i++)
+        pushed += i % 3 != 2;
+
+    return all.size() == pushed * threads;
+}
+
+// push/pop pairs per second for 1 up to 2x the hardware threads against a mutex guarded Stack
+void concurrent_stack_bench(const size_t operations)
+{
+    using namespace std::chrono;
+
+    struct Locked
+    {
+        std::mutex      mutex;
+        Stack<uint64_t> stack;
+
+        void push(uint64_t item)
+        {
+            std::lock_guard lock(mutex);
+            stack.push(item);
+        }
+
+        bool try_pop(uint64_t &item)
+        {
+            std::lock_guard lock(mutex);
+
+            if(stack.empty())
+                return false;
+
+            item = stack.peek();
+            stack.pop();
+
+            return true;
+        }
+    };
+
+    auto run = [&](auto &stack, size_t threads)
+    {
+        std::vector<std::thread> workers;
+        std::atomic<bool>        go{false};
+
+        for(size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&]
+            {
+                uint64_t item;
+
+                while(!go.load(std::memory_order_acquire));
+
+                for(size_t i = 0; i < operations / threads; i++)
+                {
+                    stack.push(i);
+                    stack.try_pop(item);
+                }
+            });
+        }
+
+        auto start = steady_clock::now();
+
+        go.store(true, std::memory_order_release);
+
+        for(auto &worker : workers)
+            worker.join();
+
+        auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+        return size_t(double(operations) / elapsed);
+    };
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    for(size_t threads = 1; threads <= hardware * 2; threads *= 2)
+    {
+        Locked                    locked;
+        ConcurrentStack<uint64_t> plain(false);
+        ConcurrentStack<uint64_t> eliminating(true);
+
+        std::cout
+                << threads << " threads, push+pop pairs/s\n"
+                << "  mutex Stack:            " << run(locked, threads)      << '\n'
+                << "  treiber:                " << run(plain, threads)       << '\n'
+                << "  treiber + elimination:  " << run(eliminating, threads) << '\n';
+    }
+}
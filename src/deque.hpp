@@ -0,0 +1,270 @@
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <bit>
+
+#include "util.hpp"
+
+// double ended queue on a growable circular buffer
+// the capacity is a power of two so wrapping an index is a mask, pushes only allocate when the buffer is full
+// and once it has grown to its working size pushing and popping at either end never touches the allocator
+
+template<class T>
+class Deque
+{
+public:
+
+    class Iterator;
+
+    Deque() = default;
+
+    Deque(std::initializer_list<T> items)
+    {
+        reserve(items.size());
+
+        for(auto &item : items)
+            push_back(item);
+    }
+
+    Deque(const Deque<T>& other)
+    {
+        copy_from(other);
+    }
+
+    Deque(Deque<T>&& other) noexcept
+    {
+        move_from(std::move(other));
+    }
+
+    ~Deque()
+    {
+        destroy();
+    }
+
+    Deque<T>& operator=(const Deque<T>& other)
+    {
+        if(this != &other)
+        {
+            destroy();
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    Deque<T>& operator=(Deque<T>&& other) noexcept
+    {
+        if(this != &other)
+        {
+            destroy();
+            move_from(std::move(other));
+        }
+
+        return *this;
+    }
+
+    template<typename... A>
+    T& emplace_back(A&&... a)
+    {
+        if(m_size == m_capacity)
+            grow(m_capacity * 2);
+
+        T *slot = new (m_data + wrap(m_head + m_size)) T(std::forward<A>(a)...);
+        m_size++;
+
+        return *slot;
+    }
+
+    template<typename... A>
+    T& emplace_front(A&&... a)
+    {
+        if(m_size == m_capacity)
+            grow(m_capacity * 2);
+
+        m_head = wrap(m_head - 1);
+
+        T *slot = new (m_data + m_head) T(std::forward<A>(a)...);
+        m_size++;
+
+        return *slot;
+    }
+
+    void push_back(T item)
+    {
+        emplace_back(std::move(item));
+    }
+
+    void push_front(T item)
+    {
+        emplace_front(std::move(item));
+    }
+
+    void pop_back()
+    {
+        if(empty())
+            return;
+
+        m_size--;
+        m_data[wrap(m_head + m_size)].~T();
+    }
+
+    void pop_front()
+    {
+        if(empty())
+            return;
+
+        m_data[m_head].~T();
+        m_head = wrap(m_head + 1);
+        m_size--;
+    }
+
+    // destroys every item but keeps the buffer
+    void clear()
+    {
+        while(!empty())
+            pop_back();
+
+        m_head = 0;
+    }
+
+    void reserve(size_t amount)
+    {
+        if(amount > m_capacity)
+            grow(amount);
+    }
+
+    T& operator[](size_t index) { return get_element(index); }
+
+    const T& operator[](size_t index) const { return get_element(index); }
+
+    [[nodiscard]]
+    T& front() const { return get_element(0); }
+
+    [[nodiscard]]
+    T& back() const { return get_element(m_size - 1); }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    inline size_t capacity() const { return m_capacity; }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_size == 0; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, m_size); }
+
+private:
+    T      *m_data     = nullptr;
+    size_t  m_head     = 0;
+    size_t  m_size     = 0;
+    size_t  m_capacity = 0;
+
+    inline size_t wrap(size_t index) const
+    {
+        return index & (m_capacity - 1);
+    }
+
+    inline T& get_element(size_t index) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return m_data[wrap(m_head + index)];
+    }
+
+    // moves the items to the front of a new buffer so the ring starts unwrapped
+    void grow(size_t amount)
+    {
+        size_t capacity = std::bit_ceil(amount < 8 ? 8 : amount);
+        T     *data     = std::allocator<T>().allocate(capacity);
+
+        for(size_t i = 0; i < m_size; i++)
+        {
+            T &item = m_data[wrap(m_head + i)];
+
+            new (data + i) T(std::move(item));
+            item.~T();
+        }
+
+        if(m_data)
+            std::allocator<T>().deallocate(m_data, m_capacity);
+
+        m_data     = data;
+        m_head     = 0;
+        m_capacity = capacity;
+    }
+
+    void destroy()
+    {
+        clear();
+
+        if(m_data)
+            std::allocator<T>().deallocate(m_data, m_capacity);
+
+        m_data     = nullptr;
+        m_capacity = 0;
+    }
+
+    void copy_from(const Deque<T>& other)
+    {
+        reserve(other.m_size);
+
+        for(size_t i = 0; i < other.m_size; i++)
+            push_back(other[i]);
+    }
+
+    void move_from(Deque<T>&& other)
+    {
+        m_data     = other.m_data;
+        m_head     = other.m_head;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_data     = nullptr;
+        other.m_head     = 0;
+        other.m_size     = 0;
+        other.m_capacity = 0;
+    }
+};
+
+template<class T>
+class Deque<T>::Iterator
+{
+public:
+    Iterator(const Deque<T> *deque, size_t index) : m_deque(deque), m_index(index) {}
+
+    T& operator*() const { return m_deque->m_data[m_deque->wrap(m_deque->m_head + m_index)]; }
+
+    Iterator& operator++()
+    {
+        m_index++;
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator temp = *this;
+        m_index++;
+        return temp;
+    }
+
+    Iterator& operator--()
+    {
+        m_index--;
+        return *this;
+    }
+
+    Iterator operator+(size_t n) const { return Iterator(m_deque, m_index + n); }
+    Iterator operator-(size_t n) const { return Iterator(m_deque, m_index - n); }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_index == b.m_index; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_index != b.m_index; }
+
+private:
+    const Deque<T> *m_deque;
+    size_t          m_index;
+};
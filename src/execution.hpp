@@ -0,0 +1,444 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <type_traits>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "common.hpp"
+#include "thread_pool.hpp"
+
+// execution policies for the container:: algorithms
+// seq is the plain serial loop, par splits a random access container into chunks run on a thread pool,
+// par_unseq does the same and also lets the loop inside a chunk be vectorized, so the order items are
+// visited in is unspecified and for floating point sum the grouping of the additions too
+// containers without random access always run serially
+
+namespace execution
+{
+    struct sequenced_policy {};
+
+    struct parallel_policy
+    {
+        ThreadPool *pool = nullptr;
+
+        // the same policy on another pool than the global one
+        parallel_policy on(ThreadPool &other) const { return { &other }; }
+    };
+
+    struct parallel_unsequenced_policy
+    {
+        ThreadPool *pool = nullptr;
+
+        parallel_unsequenced_policy on(ThreadPool &other) const { return { &other }; }
+    };
+
+    inline constexpr sequenced_policy            seq{};
+    inline constexpr parallel_policy             par{};
+    inline constexpr parallel_unsequenced_policy par_unseq{};
+}
+
+template<typename P>
+concept is_execution_policy =
+        std::is_same_v<std::remove_cvref_t<P>, execution::sequenced_policy> ||
+        std::is_same_v<std::remove_cvref_t<P>, execution::parallel_policy> ||
+        std::is_same_v<std::remove_cvref_t<P>, execution::parallel_unsequenced_policy>;
+
+template<typename C>
+concept is_random_access_container = is_container<C> && requires(C c)
+{
+    c.begin()[0];
+    c.end() - c.begin();
+};
+
+namespace container
+{
+    namespace detail
+    {
+        // below this many items the pool costs more than it saves
+        static constexpr size_t parallel_grain = 1 << 15;
+
+        // how often a chunk looks whether another one already settled the answer
+        static constexpr size_t stop_check = 1 << 12;
+
+        // width of the independent accumulators and of the blocks compared at once when vectorizing
+        static constexpr size_t lanes = 16;
+
+        template<typename P, typename C>
+        inline constexpr bool runs_parallel =
+                !std::is_same_v<std::remove_cvref_t<P>, execution::sequenced_policy> && is_random_access_container<C>;
+
+        template<typename P>
+        inline constexpr bool unsequenced = std::is_same_v<std::remove_cvref_t<P>, execution::parallel_unsequenced_policy>;
+
+        template<typename P>
+        inline ThreadPool& pool_of(const P &policy)
+        {
+            return policy.pool ? *policy.pool : ThreadPool::global();
+        }
+
+        // fn(first, last) over [0, count), on the pool if it is worth it
+        template<typename P, typename FN>
+        void run(const P &policy, size_t count, FN fn)
+        {
+            if(count < parallel_grain)
+                fn(size_t(0), count);
+            else
+                pool_of(policy).run_chunks(count, fn);
+        }
+
+        template<typename C>
+        using value_of = std::remove_cvref_t<decltype(*std::declval<C&>().begin())>;
+
+        // sum of [first, last) with lanes accumulators side by side, the vectorizer maps them onto registers,
+        // the tail goes into the same lanes and the lanes are added as a tree so the grouping only depends on last - first
+        template<typename T, typename It>
+        T lane_sum(It data, size_t first, size_t last)
+        {
+            T partial[lanes] = {};
+
+            size_t i = first;
+
+            for(; i + lanes <= last; i += lanes)
+            {
+                for(size_t j = 0; j < lanes; j++)
+                    partial[j] += data[i + j];
+            }
+
+            for(size_t j = 0; i < last; i++, j++)
+                partial[j] += data[i];
+
+            for(size_t width = lanes / 2; width > 0; width /= 2)
+            {
+                for(size_t j = 0; j < width; j++)
+                    partial[j] += partial[j + width];
+            }
+
+            return partial[0];
+        }
+
+        template<typename T, typename It>
+        T serial_sum(It data, size_t first, size_t last)
+        {
+            T total = T();
+
+            for(size_t i = first; i < last; i++)
+                total += data[i];
+
+            return total;
+        }
+
+        // first index in [first, last) where fn holds, npos if there is none
+        // unsequenced tests a whole block before branching so the tests vectorize
+        template<bool Unsequenced, typename It, typename FN>
+        size_t find_if(It data, size_t first, size_t last, FN fn)
+        {
+            size_t i = first;
+
+            if constexpr(Unsequenced)
+            {
+                for(; i + lanes <= last; i += lanes)
+                {
+                    unsigned any = 0;
+
+                    for(size_t j = 0; j < lanes; j++)
+                        any |= unsigned(bool(fn(data[i + j])));
+
+                    if(any)
+                        break;
+                }
+            }
+
+            for(; i < last; i++)
+            {
+                if(fn(data[i]))
+                    return i;
+            }
+
+            return npos;
+        }
+
+        // lowest index where fn holds across the whole container, chunks past an index already found give up early
+        template<typename P, typename C, typename FN>
+        size_t parallel_find_if(const P &policy, C &container, size_t offset, FN fn)
+        {
+            auto   data  = container.begin();
+            size_t count = size_t(container.end() - data);
+
+            if(offset >= count)
+                return npos;
+
+            std::atomic<size_t> best{npos};
+
+            run(policy, count - offset, [&](size_t first, size_t last)
+            {
+                first += offset;
+                last  += offset;
+
+                for(size_t block = first; block < last; block += stop_check)
+                {
+                    if(best.load(std::memory_order_relaxed) < block)
+                        return;
+
+                    size_t end   = block + stop_check < last ? block + stop_check : last;
+                    size_t found = find_if<unsequenced<P>>(data, block, end, fn);
+
+                    if(found == npos)
+                        continue;
+
+                    size_t current = best.load(std::memory_order_relaxed);
+
+                    while(found < current && !best.compare_exchange_weak(current, found, std::memory_order_relaxed));
+
+                    return;
+                }
+            });
+
+            return best.load(std::memory_order_relaxed);
+        }
+    }
+
+    template<is_execution_policy P, is_container C, typename FN>
+    void map(const P &policy, C& container, FN fn)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+        {
+            map(container, fn);
+        }
+        else
+        {
+            auto data = container.begin();
+
+            detail::run(policy, size_t(container.end() - data), [&](size_t first, size_t last)
+            {
+                if constexpr(detail::unsequenced<P>)
+                {
+#pragma GCC ivdep
+                    for(size_t i = first; i < last; i++)
+                        data[i] = fn(data[i]);
+                }
+                else
+                {
+                    for(size_t i = first; i < last; i++)
+                        data[i] = fn(data[i]);
+                }
+            });
+        }
+    }
+
+    // fn is called from several threads at once under par and par_unseq
+    template<is_execution_policy P, is_container C, typename FN>
+    void each(const P &policy, C& container, FN fn)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+        {
+            each(container, fn);
+        }
+        else
+        {
+            auto data = container.begin();
+
+            detail::run(policy, size_t(container.end() - data), [&](size_t first, size_t last)
+            {
+                for(size_t i = first; i < last; i++)
+                    fn(data[i]);
+            });
+        }
+    }
+
+    template<is_execution_policy P, is_container C, typename FN>
+    bool every(const P &policy, C& container, FN fn)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+            return every(container, fn);
+        else
+            return detail::parallel_find_if(policy, container, 0, [&](const auto &item) { return !fn(item); }) == npos;
+    }
+
+    template<is_execution_policy P, is_container C, typename T>
+    bool includes(const P &policy, C& container, const T& item)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+            return includes(container, item);
+        else
+            return detail::parallel_find_if(policy, container, 0, [&](const auto &i) { return i == item; }) != npos;
+    }
+
+    template<is_execution_policy P, is_container C, typename T>
+    size_t index_of(const P &policy, C& container, const T& item, size_t offset = 0)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+            return index_of(container, item, offset);
+        else
+            return detail::parallel_find_if(policy, container, offset, [&](const auto &i) { return i == item; });
+    }
+
+    // start and end are inclusive, nothing is filled if either is out of range
+    template<is_execution_policy P, is_container C, typename T>
+    void fill(const P &policy, C& container, size_t start, size_t end, const T& item)
+    {
+        if constexpr(!detail::runs_parallel<P, C>)
+        {
+            fill(container, start, end, item);
+        }
+        else
+        {
+            if(start >= container.size() || end >= container.size() || start > end)
+                return;
+
+            auto data = container.begin();
+
+            detail::run(policy, end - start + 1, [&](size_t first, size_t last)
+            {
+#pragma GCC ivdep
+                for(size_t i = start + first; i < start + last; i++)
+                    data[i] = item;
+            });
+        }
+    }
+
+    // the value type's default is the sum of an empty container
+    // under par the chunks are added in order but how the items are chunked depends on the pool size, use tree_sum
+    // when a floating point total has to come out the same on every machine
+    template<is_execution_policy P, is_container C>
+    auto sum(const P &policy, const C& container)
+    {
+        using T = detail::value_of<const C>;
+
+        if constexpr(!detail::runs_parallel<P, C>)
+        {
+            T total = T();
+
+            for(auto &item : container)
+                total += item;
+
+            return total;
+        }
+        else
+        {
+            auto   data  = container.begin();
+            size_t count = size_t(container.end() - data);
+
+            if(count < detail::parallel_grain)
+                return detail::unsequenced<P> ? detail::lane_sum<T>(data, 0, count) : detail::serial_sum<T>(data, 0, count);
+
+            ThreadPool &pool = detail::pool_of(policy);
+
+            // a few chunks per worker, each one adds its own items and the chunk totals are added in order
+            size_t chunks = pool.size() * 4;
+            size_t size   = (count + chunks - 1) / chunks;
+
+            std::vector<T> partial(chunks);
+
+            pool.run_chunks(chunks, [&](size_t first, size_t last)
+            {
+                for(size_t c = first; c < last; c++)
+                {
+                    size_t begin = c * size < count ? c * size : count;
+                    size_t end   = begin + size < count ? begin + size : count;
+
+                    partial[c] = detail::unsequenced<P> ? detail::lane_sum<T>(data, begin, end) : detail::serial_sum<T>(data, begin, end);
+                }
+            });
+
+            T total = T();
+
+            for(auto &value : partial)
+                total += value;
+
+            return total;
+        }
+    }
+
+    // pairwise summation over fixed blocks, the additions are grouped the same way whatever the policy and the
+    // number of threads so a floating point total is reproducible, and the rounding error grows with log n instead of n
+    template<is_execution_policy P, is_container C>
+    auto tree_sum(const P &policy, const C& container)
+    {
+        using T = detail::value_of<const C>;
+
+        static constexpr size_t block = 1 << 12;
+
+        static_assert(is_random_access_container<const C>, "tree_sum needs random access");
+
+        auto   data   = container.begin();
+        size_t count  = size_t(container.end() - data);
+        size_t blocks = (count + block - 1) / block;
+
+        if(blocks == 0)
+            return T();
+
+        std::vector<T> partial(blocks);
+
+        auto sum_blocks = [&](size_t first, size_t last)
+        {
+            for(size_t b = first; b < last; b++)
+                partial[b] = detail::lane_sum<T>(data, b * block, b * block + block < count ? b * block + block : count);
+        };
+
+        if constexpr(std::is_same_v<std::remove_cvref_t<P>, execution::sequenced_policy>)
+            sum_blocks(0, blocks);
+        else if(count < detail::parallel_grain)
+            sum_blocks(0, blocks);
+        else
+            detail::pool_of(policy).run_chunks(blocks, sum_blocks);
+
+        // neighbours are added level by level, an odd one out moves up as is
+        for(size_t width = blocks; width > 1; width = (width + 1) / 2)
+        {
+            for(size_t i = 0; i < width / 2; i++)
+                partial[i] = partial[2 * i] + partial[2 * i + 1];
+
+            if(width & 1)
+                partial[width / 2] = partial[width - 1];
+        }
+
+        return partial[0];
+    }
+}
+
+// the policies against each other on sum, tree_sum, map and index_of of a missing value
+void execution_bench(const size_t items = 100'000'000)
+{
+    using namespace std::chrono;
+
+    std::vector<float> values(items);
+
+    for(size_t i = 0; i < items; i++)
+        values[i] = float(i % 1000) * 0.5f;
+
+    auto time = [](auto fn)
+    {
+        auto start = steady_clock::now();
+        fn();
+        return duration_cast<duration<double>>(steady_clock::now() - start).count() * 1e3;
+    };
+
+    std::cout << items << " floats, " << ThreadPool::global().size() << " workers, ms\n";
+
+    auto report = [&](const char *name, const auto &policy)
+    {
+        float  total = 0, tree = 0;
+        size_t index = 0;
+
+        double sum_time   = time([&] { total = container::sum(policy, values); });
+        double tree_time  = time([&] { tree = container::tree_sum(policy, values); });
+        double map_time   = time([&] { container::map(policy, values, [](float v) { return v * 1.0001f; }); });
+        double index_time = time([&] { index = container::index_of(policy, values, -1.0f); });
+
+        std::cout
+                << "  " << name
+                << " sum: " << sum_time << " (" << total << ")"
+                << ", tree_sum: " << tree_time << " (" << tree << ")"
+                << ", map: " << map_time
+                << ", index_of: " << index_time << (index == npos ? "" : " WRONG") << '\n';
+    };
+
+    report("seq      ", execution::seq);
+    report("par      ", execution::par);
+    report("par_unseq", execution::par_unseq);
+}
@@ -0,0 +1,614 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <bit>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "map.hpp"
+#include "OMap.hpp"
+#include "trie.hpp"
+#include "simd.hpp"
+
+// probabilistic membership filters, contains() is never wrong about a key that was inserted
+// and wrong about a key that wasn't with roughly the configured false positive rate
+
+namespace filter
+{
+    // std::hash is the identity for integers, the filters need every bit of the hash to be random
+    inline uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+    template<class K>
+    inline uint64_t hash(const K &key)
+    {
+        return mix(std::hash<K>()(key));
+    }
+
+    // odd multipliers that pick the bit a key sets in each word of a bloom block
+    alignas(32) inline constexpr uint32_t block_salts[8] =
+    {
+        0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+        0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31,
+    };
+
+    // the bloom block probed as one register, compiled for AVX2 whatever the build targets and picked at runtime
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+    namespace avx2
+    {
+        // a bit per word, one multiply and shift for all eight
+        inline __m256i mask(uint32_t key)
+        {
+            __m256i salt  = _mm256_load_si256(reinterpret_cast<const __m256i*>(block_salts));
+            __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(key)), salt), 27);
+
+            return _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+        }
+
+        inline void insert(uint32_t *words, uint32_t key)
+        {
+            __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words), _mm256_or_si256(bits, mask(key)));
+        }
+
+        inline bool contains(const uint32_t *words, uint32_t key)
+        {
+            __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+            return _mm256_testc_si256(bits, mask(key));
+        }
+    }
+#pragma GCC pop_options
+#endif
+}
+
+// split block bloom filter, every key sets one bit in each of the eight 32 bit words of a single 256 bit block
+// so a probe is one cache line, and on a cpu with AVX2 one multiply, shift and test over the whole block
+class BlockedBloomFilter
+{
+public:
+
+    // sized for the expected number of keys at the false positive rate, more keys than expected raise the rate
+    explicit BlockedBloomFilter(size_t expected = 1024, double false_positive_rate = 0.01)
+    {
+        // the blocked layout needs about 15% more bits than a classic bloom filter for the same rate
+        double bits_per_key = -std::log2(false_positive_rate) * 1.44 * 1.15;
+        size_t bits         = size_t(double(expected ? expected : 1) * bits_per_key);
+
+        m_blocks.resize((bits + 255) / 256);
+    }
+
+    template<class K>
+    void insert(const K &key)
+    {
+        insert_hash(filter::hash(key));
+    }
+
+    template<class K>
+    [[nodiscard]]
+    bool contains(const K &key) const
+    {
+        return contains_hash(filter::hash(key));
+    }
+
+    void insert_hash(uint64_t hash)
+    {
+        Block &block = m_blocks[block_of(hash)];
+
+#if defined(__x86_64__) || defined(__i386__)
+        if(simd::level() != simd::Level::Base)
+        {
+            filter::avx2::insert(block.words, uint32_t(hash));
+            return;
+        }
+#endif
+
+        for(size_t i = 0; i < 8; i++)
+            block.words[i] |= bit(uint32_t(hash), i);
+    }
+
+    [[nodiscard]]
+    bool contains_hash(uint64_t hash) const
+    {
+        const Block &block = m_blocks[block_of(hash)];
+
+#if defined(__x86_64__) || defined(__i386__)
+        if(simd::level() != simd::Level::Base)
+            return filter::avx2::contains(block.words, uint32_t(hash));
+#endif
+
+        for(size_t i = 0; i < 8; i++)
+        {
+            if(!(block.words[i] & bit(uint32_t(hash), i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    void clear()
+    {
+        std::fill(m_blocks.begin(), m_blocks.end(), Block());
+    }
+
+    [[nodiscard]]
+    size_t memory() const { return m_blocks.size() * sizeof(Block); }
+
+private:
+
+    struct alignas(32) Block
+    {
+        uint32_t words[8] = {};
+    };
+
+    std::vector<Block> m_blocks;
+
+    // the high half picks the block without a modulo, the low half picks the bits
+    inline size_t block_of(uint64_t hash) const
+    {
+        return size_t(((hash >> 32) * uint64_t(m_blocks.size())) >> 32);
+    }
+
+    static inline uint32_t bit(uint32_t key, size_t word)
+    {
+        return 1u << ((key * filter::block_salts[word]) >> 27);
+    }
+};
+
+// cuckoo filter, buckets of four fingerprints where a key can live in one of two buckets
+// unlike a bloom filter it can erase keys, and a bucket is probed for a fingerprint in one go with a SWAR compare
+// a uint8_t fingerprint gives about 3% false positives and a uint16_t one about 0.01% for 1 or 2 bytes per slot
+template<class F = uint16_t>
+class CuckooFilter
+{
+    static_assert(std::is_same_v<F, uint8_t> || std::is_same_v<F, uint16_t>);
+
+public:
+
+    static constexpr size_t slots = 4;
+
+    explicit CuckooFilter(size_t capacity = 1024)
+    {
+        // about 95% of the slots can be filled before inserts start failing
+        size_t buckets = std::bit_ceil(size_t(double(capacity ? capacity : 1) / slots / 0.95) + 1);
+
+        m_mask = buckets - 1;
+        m_buckets.resize(buckets);
+    }
+
+    // returns false once the filter is full, the key is not in it then
+    template<class K>
+    bool insert(const K &key)
+    {
+        auto [index, fingerprint] = locate(filter::hash(key));
+
+        if(m_victim.used)
+            return false;
+
+        if(put(index, fingerprint) || put(alternate(index, fingerprint), fingerprint))
+        {
+            m_size++;
+            return true;
+        }
+
+        // kicks fingerprints around until one lands in a free slot
+        std::minstd_rand rng(uint32_t(index ^ fingerprint));
+
+        if(rng() & 1)
+            index = alternate(index, fingerprint);
+
+        for(size_t kick = 0; kick < max_kicks; kick++)
+        {
+            F &slot = m_buckets[index].slot[rng() % slots];
+
+            std::swap(slot, fingerprint);
+
+            index = alternate(index, fingerprint);
+
+            if(put(index, fingerprint))
+            {
+                m_size++;
+                return true;
+            }
+        }
+
+        // nothing is lost, the last one out waits on the side and the filter refuses further inserts
+        m_victim = { true, index, fingerprint };
+        m_size++;
+
+        return true;
+    }
+
+    template<class K>
+    [[nodiscard]]
+    bool contains(const K &key) const
+    {
+        auto [index, fingerprint] = locate(filter::hash(key));
+
+        if(has(index, fingerprint))
+            return true;
+
+        size_t other = alternate(index, fingerprint);
+
+        if(has(other, fingerprint))
+            return true;
+
+        return m_victim.used && m_victim.fingerprint == fingerprint && (m_victim.index == index || m_victim.index == other);
+    }
+
+    // only erase keys that were inserted, erasing anything else can drop another key's fingerprint
+    template<class K>
+    bool erase(const K &key)
+    {
+        auto [index, fingerprint] = locate(filter::hash(key));
+
+        size_t other = alternate(index, fingerprint);
+
+        if(m_victim.used && m_victim.fingerprint == fingerprint && (m_victim.index == index || m_victim.index == other))
+        {
+            m_victim.used = false;
+            m_size--;
+            return true;
+        }
+
+        if(!take(index, fingerprint) && !take(other, fingerprint))
+            return false;
+
+        m_size--;
+
+        // there is room now, the victim gets another go
+        if(m_victim.used)
+        {
+            Victim victim = m_victim;
+
+            m_victim.used = false;
+            m_size--;
+
+            reinsert(victim.index, victim.fingerprint);
+        }
+
+        return true;
+    }
+
+    void clear()
+    {
+        std::fill(m_buckets.begin(), m_buckets.end(), Bucket());
+
+        m_victim.used = false;
+        m_size        = 0;
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    bool full() const { return m_victim.used; }
+
+    [[nodiscard]]
+    size_t memory() const { return m_buckets.size() * sizeof(Bucket); }
+
+private:
+
+    // four fingerprints read as one integer
+    using Word = std::conditional_t<sizeof(F) == 1, uint32_t, uint64_t>;
+
+    struct alignas(sizeof(Word)) Bucket
+    {
+        F slot[slots] = {};
+    };
+
+    struct Victim
+    {
+        bool   used        = false;
+        size_t index       = 0;
+        F      fingerprint = 0;
+    };
+
+    static constexpr size_t max_kicks = 500;
+
+    // 0x0001 in every lane and the top bit of every lane
+    static constexpr Word lanes = sizeof(F) == 1 ? Word(0x01010101u) : Word(0x0001000100010001ull);
+    static constexpr Word highs = lanes << (sizeof(F) * 8 - 1);
+
+    std::vector<Bucket> m_buckets;
+    size_t              m_mask;
+    size_t              m_size = 0;
+    Victim              m_victim;
+
+    // the fingerprint comes from the low bits and is never 0 since 0 marks an empty slot
+    inline std::pair<size_t, F> locate(uint64_t hash) const
+    {
+        F fingerprint = F(hash);
+
+        if(fingerprint == 0)
+            fingerprint = 1;
+
+        return { size_t(hash >> 32) & m_mask, fingerprint };
+    }
+
+    // partial key cuckoo hashing, the other bucket only depends on this one and the fingerprint
+    inline size_t alternate(size_t index, F fingerprint) const
+    {
+        return (index ^ size_t(filter::mix(fingerprint))) & m_mask;
+    }
+
+    // true if any lane of the bucket equals the fingerprint, the classic has-zero-byte trick on the xor
+    inline bool has(size_t index, F fingerprint) const
+    {
+        Word word;
+        std::memcpy(&word, m_buckets[index].slot, sizeof(Word));
+
+        word ^= lanes * Word(fingerprint);
+
+        return ((word - lanes) & ~word & highs) != 0;
+    }
+
+    inline bool put(size_t index, F fingerprint)
+    {
+        for(F &slot : m_buckets[index].slot)
+        {
+            if(slot == 0)
+            {
+                slot = fingerprint;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline bool take(size_t index, F fingerprint)
+    {
+        for(F &slot : m_buckets[index].slot)
+        {
+            if(slot == fingerprint)
+            {
+                slot = 0;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void reinsert(size_t index, F fingerprint)
+    {
+        if(put(index, fingerprint) || put(alternate(index, fingerprint), fingerprint))
+        {
+            m_size++;
+            return;
+        }
+
+        m_victim = { true, index, fingerprint };
+        m_size++;
+    }
+};
+
+// puts a filter in front of a container so lookups of missing keys usually never reach it
+// a bloom filter keeps the bits of erased keys, which only costs a few more trips to the container,
+// a cuckoo filter erases them too, and if the filter ever refuses an insert every lookup goes to the container
+// until clear() or until enough keys are erased that the filter can be rebuilt from the container
+template<class C, class Key, class F = BlockedBloomFilter>
+class Filtered
+{
+public:
+
+    // the arguments go to the filter
+    template<typename... A>
+    explicit Filtered(A&&... a) : m_filter(std::forward<A>(a)...) {}
+
+    // only a key the container did not have goes into the filter, overwriting a value leaves the filter alone
+    template<typename... A>
+    decltype(auto) set(const Key &key, A&&... a)
+    {
+        size_t before = m_container.size();
+
+        decltype(auto) result = m_container.set(key, std::forward<A>(a)...);
+
+        if(m_container.size() != before)
+            filter_key(key);
+
+        return result;
+    }
+
+    auto get(const Key &key) const -> decltype(std::declval<const C&>().get(key))
+    {
+        if(!m_bypass && !m_filter.contains(key))
+            return nullptr;
+
+        return m_container.get(key);
+    }
+
+    bool contains(const Key &key) const
+    {
+        return get(key) != nullptr;
+    }
+
+    bool erase(const Key &key)
+    {
+        if(!m_container.erase(key))
+            return false;
+
+        if constexpr(requires { m_filter.erase(key); })
+        {
+            // a key the filter refused is not in it and erasing it could take another key's fingerprint
+            if(!m_bypass)
+                m_filter.erase(key);
+        }
+
+        // once half the keys that overfilled the filter are gone the rest should fit again
+        if(m_bypass && m_container.size() <= m_bypass_size / 2)
+            rebuild();
+
+        return true;
+    }
+
+    void clear() requires requires(C &c) { c.clear(); }
+    {
+        m_container.clear();
+        m_filter.clear();
+        m_bypass = false;
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_container.size(); }
+
+    [[nodiscard]]
+    C& container() { return m_container; }
+
+    [[nodiscard]]
+    const F& filter() const { return m_filter; }
+
+private:
+    C      m_container;
+    F      m_filter;
+    bool   m_bypass = false;
+    // the container's size when the filter first refused a key
+    size_t m_bypass_size = 0;
+
+    inline void filter_key(const Key &key)
+    {
+        if constexpr(std::is_same_v<decltype(m_filter.insert(key)), bool>)
+        {
+            if(!m_filter.insert(key) && !m_bypass)
+            {
+                m_bypass      = true;
+                m_bypass_size = m_container.size();
+            }
+        }
+        else
+        {
+            m_filter.insert(key);
+        }
+    }
+
+    // refills the filter from the keys in the container, lookups keep going to the container if it still overflows
+    void rebuild()
+    {
+        m_filter.clear();
+        m_bypass = false;
+
+        if constexpr(requires { m_container.keys_with_prefix(""); })
+        {
+            for(const auto &key : m_container.keys_with_prefix(""))
+                filter_key(Key(key));
+        }
+        else
+        {
+            for(const auto &entry : m_container)
+            {
+                // Map hands out its chains, OMap its records
+                if constexpr(requires { entry.key; })
+                    filter_key(entry.key);
+                else
+                    for(const auto &record : entry)
+                        filter_key(record.key);
+            }
+        }
+    }
+};
+
+template<class K, class V, class F = BlockedBloomFilter>
+using FilteredMap = Filtered<Map<K, V>, K, F>;
+
+template<class K, class V, class F = BlockedBloomFilter>
+using FilteredOMap = Filtered<OMap<K, V>, K, F>;
+
+template<class T, class F = BlockedBloomFilter>
+using FilteredTrie = Filtered<Trie<T>, std::string_view, F>;
+
+// lookups per second with and without a filter in front for a few hit rates
+void filter_bench(const size_t items, const size_t lookups = 1 << 20)
+{
+    using namespace std::chrono;
+
+    std::mt19937_64 rng(11);
+
+    std::vector<uint64_t>    keys(items);
+    std::vector<std::string> words(items);
+
+    for(size_t i = 0; i < items; i++)
+    {
+        keys[i]  = rng();
+        words[i] = std::to_string(keys[i]);
+    }
+
+    Map<uint64_t, uint64_t>                          map;
+    FilteredMap<uint64_t, uint64_t>                  bloom_map(items, 0.01);
+    FilteredMap<uint64_t, uint64_t, CuckooFilter<>>  cuckoo_map(items);
+    Trie<uint64_t>                                   trie;
+    FilteredTrie<uint64_t>                           bloom_trie(items, 0.01);
+
+    for(size_t i = 0; i < items; i++)
+    {
+        map.set(keys[i], uint64_t(i));
+        bloom_map.set(keys[i], uint64_t(i));
+        cuckoo_map.set(keys[i], uint64_t(i));
+        trie.set(words[i], uint64_t(i));
+        bloom_trie.set(words[i], uint64_t(i));
+    }
+
+    for(size_t hit_percent : {100, 50, 10, 0})
+    {
+        std::vector<uint64_t>    probes(lookups);
+        std::vector<std::string> probe_words(lookups);
+
+        for(size_t i = 0; i < lookups; i++)
+        {
+            probes[i]      = rng() % 100 < hit_percent ? keys[rng() % items] : rng();
+            probe_words[i] = std::to_string(probes[i]);
+        }
+
+        auto rate = [&](auto &container, auto &queries)
+        {
+            size_t found = 0;
+
+            auto start = steady_clock::now();
+
+            for(auto &query : queries)
+                found += container.get(query) != nullptr;
+
+            auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+            // keeps the work from being optimized out
+            if(found == size_t(-1))
+                std::cout << ' ';
+
+            return size_t(double(lookups) / elapsed);
+        };
+
+        std::cout
+                << items << " keys, " << hit_percent << "% hits, lookups/s\n"
+                << "  Map:                  " << rate(map, probes)              << '\n'
+                << "  Map + bloom:          " << rate(bloom_map, probes)        << '\n'
+                << "  Map + cuckoo:         " << rate(cuckoo_map, probes)       << '\n'
+                << "  Trie:                 " << rate(trie, probe_words)        << '\n'
+                << "  Trie + bloom:         " << rate(bloom_trie, probe_words)  << '\n';
+    }
+
+    std::cout
+            << "filter memory, bloom: " << bloom_map.filter().memory()
+            << " bytes, cuckoo: " << cuckoo_map.filter().memory() << " bytes\n";
+}
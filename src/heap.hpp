@@ -0,0 +1,790 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <random>
+#include <queue>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "vector.hpp"
+
+// priority queues, fn(a, b) returns true when a has to come out before b so std::less gives a min heap
+
+// implicit d-ary heap on a Vector
+// a node's D children sit next to each other so with D = 4 a sift down reads one cache line per level,
+// and the tree is half as deep as a binary heap which makes push cheaper too
+template<class T, typename FN = std::less<T>, size_t D = 4>
+class DHeap
+{
+    static_assert(D >= 2);
+
+public:
+
+    DHeap() = default;
+
+    explicit DHeap(FN fn) : m_fn(fn) {}
+
+    // builds the heap bottom up in O(n)
+    template<is_container C>
+    explicit DHeap(const C& container, FN fn = FN()) : m_fn(fn)
+    {
+        m_heap.reserve(container.size() + 1);
+
+        for(auto &item : container)
+            m_heap.push_back(item);
+
+        if(m_heap.size() < 2)
+            return;
+
+        for(size_t i = (m_heap.size() - 2) / D + 1; i-- > 0;)
+            sift_down(i);
+    }
+
+    void push(T item)
+    {
+        m_heap.push_back(std::move(item));
+        sift_up(m_heap.size() - 1);
+    }
+
+    template<typename... A>
+    void emplace(A&&... a)
+    {
+        push(T(std::forward<A>(a)...));
+    }
+
+    [[nodiscard]]
+    const T& top() const { return m_heap.front(); }
+
+    void pop()
+    {
+        if(empty())
+            return;
+
+        T *data = m_heap.data();
+
+        data[0] = std::move(data[m_heap.size() - 1]);
+        m_heap.pop_back();
+
+        if(!empty())
+            sift_down(0);
+    }
+
+    // pops and returns the top
+    T take()
+    {
+        T item = std::move(m_heap.front());
+        pop();
+        return item;
+    }
+
+    void reserve(size_t amount) { m_heap.reserve(amount); }
+
+    void clear() { m_heap.clear(); }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_heap.size(); }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_heap.empty(); }
+
+    // the items in heap order
+    [[nodiscard]]
+    const Vector<T>& items() const { return m_heap; }
+
+private:
+    Vector<T> m_heap;
+    FN        m_fn;
+
+    // moves the item into a hole instead of swapping at every level
+    void sift_up(size_t index)
+    {
+        T *data = m_heap.data();
+        T  item = std::move(data[index]);
+
+        while(index > 0)
+        {
+            size_t parent = (index - 1) / D;
+
+            if(!m_fn(item, data[parent]))
+                break;
+
+            data[index] = std::move(data[parent]);
+            index = parent;
+        }
+
+        data[index] = std::move(item);
+    }
+
+    void sift_down(size_t index)
+    {
+        T           *data = m_heap.data();
+        const size_t size = m_heap.size();
+        T            item = std::move(data[index]);
+
+        while(true)
+        {
+            size_t first = index * D + 1;
+
+            if(first >= size)
+                break;
+
+            size_t last = first + D < size ? first + D : size;
+            size_t best = first;
+
+            for(size_t child = first + 1; child < last; child++)
+            {
+                if(m_fn(data[child], data[best]))
+                    best = child;
+            }
+
+            if(!m_fn(data[best], item))
+                break;
+
+            data[index] = std::move(data[best]);
+            index = best;
+        }
+
+        data[index] = std::move(item);
+    }
+};
+
+template<class T, typename FN = std::less<T>>
+using BinaryHeap = DHeap<T, FN, 2>;
+
+// pairing heap, a heap ordered tree where push, merge and decrease_key are O(1)
+// and pop is amortized O(log n), push hands out a node that stays valid until that item is popped
+template<class T, typename FN = std::less<T>>
+class PairingHeap
+{
+public:
+
+    class Node
+    {
+    public:
+        [[nodiscard]]
+        const T& value() const { return m_value; }
+
+    private:
+        friend class PairingHeap;
+
+        explicit Node(T value) : m_value(std::move(value)) {}
+
+        T     m_value;
+        Node *m_child   = nullptr;
+        Node *m_sibling = nullptr;
+        // the left sibling, or the parent for the leftmost child
+        Node *m_prev    = nullptr;
+    };
+
+    PairingHeap() = default;
+
+    explicit PairingHeap(FN fn) : m_fn(fn) {}
+
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+
+    PairingHeap(PairingHeap&& other) noexcept : m_root(other.m_root), m_size(other.m_size), m_fn(other.m_fn)
+    {
+        other.m_root = nullptr;
+        other.m_size = 0;
+    }
+
+    PairingHeap& operator=(PairingHeap&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+
+            m_root = other.m_root;
+            m_size = other.m_size;
+            m_fn   = other.m_fn;
+
+            other.m_root = nullptr;
+            other.m_size = 0;
+        }
+
+        return *this;
+    }
+
+    ~PairingHeap()
+    {
+        clear();
+    }
+
+    Node* push(T item)
+    {
+        Node *node = new Node(std::move(item));
+
+        m_root = meld(m_root, node);
+        m_size++;
+
+        return node;
+    }
+
+    [[nodiscard]]
+    const T& top() const
+    {
+        if(empty())
+            throw std::out_of_range("Heap is empty");
+        return m_root->m_value;
+    }
+
+    [[nodiscard]]
+    Node* top_node() const { return m_root; }
+
+    void pop()
+    {
+        if(empty())
+            return;
+
+        Node *old = m_root;
+
+        m_root = combine(old->m_child);
+        m_size--;
+
+        delete old;
+    }
+
+    T take()
+    {
+        if(empty())
+            throw std::out_of_range("Heap is empty");
+
+        T item = std::move(m_root->m_value);
+        pop();
+        return item;
+    }
+
+    // lowers the node's value, the new value may not order after the old one
+    void decrease_key(Node *node, T value)
+    {
+        if(m_fn(node->m_value, value))
+            throw std::invalid_argument("decrease_key would move the item down");
+
+        node->m_value = std::move(value);
+
+        if(node == m_root)
+            return;
+
+        detach(node);
+        m_root = meld(m_root, node);
+    }
+
+    // removes any node, the node is freed
+    void erase(Node *node)
+    {
+        if(node == m_root)
+        {
+            pop();
+            return;
+        }
+
+        detach(node);
+
+        m_root = meld(m_root, combine(node->m_child));
+        m_size--;
+
+        delete node;
+    }
+
+    // takes every item of other in O(1), other is left empty
+    void merge(PairingHeap &other)
+    {
+        if(this == &other)
+            return;
+
+        m_root  = meld(m_root, other.m_root);
+        m_size += other.m_size;
+
+        other.m_root = nullptr;
+        other.m_size = 0;
+    }
+
+    // frees every node without recursing, the tree can be as deep as the heap is large
+    void clear()
+    {
+        std::vector<Node*> pending;
+
+        if(m_root)
+            pending.push_back(m_root);
+
+        while(!pending.empty())
+        {
+            Node *node = pending.back();
+            pending.pop_back();
+
+            if(node->m_child)
+                pending.push_back(node->m_child);
+            if(node->m_sibling)
+                pending.push_back(node->m_sibling);
+
+            delete node;
+        }
+
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_size == 0; }
+
+private:
+    Node   *m_root = nullptr;
+    size_t  m_size = 0;
+    FN      m_fn;
+
+    // links two roots, the loser becomes the leftmost child of the winner
+    Node* meld(Node *a, Node *b)
+    {
+        if(!a)
+            return b;
+        if(!b)
+            return a;
+
+        if(m_fn(b->m_value, a->m_value))
+            std::swap(a, b);
+
+        b->m_prev    = a;
+        b->m_sibling = a->m_child;
+
+        if(a->m_child)
+            a->m_child->m_prev = b;
+
+        a->m_child   = b;
+        a->m_sibling = nullptr;
+        a->m_prev    = nullptr;
+
+        return a;
+    }
+
+    // cuts the node and its subtree out of the tree
+    void detach(Node *node)
+    {
+        if(node->m_prev->m_child == node)
+            node->m_prev->m_child = node->m_sibling;
+        else
+            node->m_prev->m_sibling = node->m_sibling;
+
+        if(node->m_sibling)
+            node->m_sibling->m_prev = node->m_prev;
+
+        node->m_sibling = nullptr;
+        node->m_prev    = nullptr;
+    }
+
+    // the two pass pairing, melds siblings in pairs left to right and then folds the pairs right to left
+    Node* combine(Node *first)
+    {
+        if(!first)
+            return nullptr;
+
+        Node *pairs = nullptr;
+
+        while(first)
+        {
+            Node *a = first;
+            Node *b = a->m_sibling;
+
+            first = b ? b->m_sibling : nullptr;
+
+            a->m_sibling = nullptr;
+            a->m_prev    = nullptr;
+
+            if(b)
+            {
+                b->m_sibling = nullptr;
+                b->m_prev    = nullptr;
+            }
+
+            // the pairs are chained through m_prev in reverse so the second pass can walk them back
+            Node *pair = meld(a, b);
+
+            pair->m_prev = pairs;
+            pairs = pair;
+        }
+
+        Node *root = pairs;
+
+        pairs = pairs->m_prev;
+        root->m_prev = nullptr;
+
+        while(pairs)
+        {
+            Node *next = pairs->m_prev;
+
+            pairs->m_prev = nullptr;
+            root = meld(root, pairs);
+
+            pairs = next;
+        }
+
+        return root;
+    }
+};
+
+// 4-ary heap over the ids 0..n with a position table, made for dijkstra and prim
+// every id is in the heap at most once and its key can be moved either way in O(log n)
+template<class Key, typename FN = std::less<Key>>
+class IndexedHeap
+{
+public:
+
+    IndexedHeap() = default;
+
+    explicit IndexedHeap(size_t ids, FN fn = FN()) : m_fn(fn)
+    {
+        reserve(ids);
+    }
+
+    // makes room for the ids 0..ids-1 so push never has to grow the position table
+    void reserve(size_t ids)
+    {
+        if(ids > m_position.size())
+            m_position.resize(ids, npos);
+
+        m_heap.reserve(ids + 1);
+    }
+
+    // adds the id with the key, or updates the key when the id is already queued
+    void push(size_t id, Key key)
+    {
+        if(id >= m_position.size())
+            m_position.resize(id + 1 > m_position.size() * 2 ? id + 1 : m_position.size() * 2, npos);
+
+        if(m_position[id] != npos)
+        {
+            update(id, std::move(key));
+            return;
+        }
+
+        m_heap.push_back({ std::move(key), id });
+        m_position[id] = m_heap.size() - 1;
+
+        sift_up(m_heap.size() - 1);
+    }
+
+    // sets a new key for a queued id, it may move either way
+    void update(size_t id, Key key)
+    {
+        size_t index = position(id);
+        Entry *data  = m_heap.data();
+
+        bool up = m_fn(key, data[index].key);
+
+        data[index].key = std::move(key);
+
+        if(up)
+            sift_up(index);
+        else
+            sift_down(index);
+    }
+
+    // only moves the key when the new one orders first, returns true if it did
+    bool decrease_key(size_t id, Key key)
+    {
+        size_t index = position(id);
+
+        if(!m_fn(key, m_heap.data()[index].key))
+            return false;
+
+        m_heap.data()[index].key = std::move(key);
+        sift_up(index);
+
+        return true;
+    }
+
+    [[nodiscard]]
+    size_t top() const { return m_heap.front().id; }
+
+    [[nodiscard]]
+    const Key& top_key() const { return m_heap.front().key; }
+
+    // pops and returns the id on top
+    size_t pop()
+    {
+        size_t id = top();
+
+        remove_at(0);
+
+        return id;
+    }
+
+    void erase(size_t id)
+    {
+        remove_at(position(id));
+    }
+
+    [[nodiscard]]
+    bool contains(size_t id) const
+    {
+        return id < m_position.size() && m_position[id] != npos;
+    }
+
+    [[nodiscard]]
+    const Key& key(size_t id) const { return m_heap.data()[position(id)].key; }
+
+    void clear()
+    {
+        for(size_t i = 0; i < m_heap.size(); i++)
+            m_position[m_heap.data()[i].id] = npos;
+
+        m_heap.clear();
+    }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_heap.size(); }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_heap.empty(); }
+
+private:
+    static constexpr size_t D = 4;
+
+    struct Entry
+    {
+        Key    key;
+        size_t id;
+    };
+
+    Vector<Entry>       m_heap;
+    std::vector<size_t> m_position;
+    FN                  m_fn;
+
+    inline size_t position(size_t id) const
+    {
+        if(!contains(id))
+            throw std::out_of_range("Id is not in the heap");
+        return m_position[id];
+    }
+
+    void remove_at(size_t index)
+    {
+        Entry *data = m_heap.data();
+        size_t last = m_heap.size() - 1;
+
+        m_position[data[index].id] = npos;
+
+        if(index != last)
+        {
+            bool up = m_fn(data[last].key, data[index].key);
+
+            data[index] = std::move(data[last]);
+            m_position[data[index].id] = index;
+
+            m_heap.pop_back();
+
+            if(up)
+                sift_up(index);
+            else
+                sift_down(index);
+
+            return;
+        }
+
+        m_heap.pop_back();
+    }
+
+    void sift_up(size_t index)
+    {
+        Entry *data  = m_heap.data();
+        Entry  entry = std::move(data[index]);
+
+        while(index > 0)
+        {
+            size_t parent = (index - 1) / D;
+
+            if(!m_fn(entry.key, data[parent].key))
+                break;
+
+            data[index] = std::move(data[parent]);
+            m_position[data[index].id] = index;
+
+            index = parent;
+        }
+
+        data[index] = std::move(entry);
+        m_position[data[index].id] = index;
+    }
+
+    void sift_down(size_t index)
+    {
+        Entry       *data  = m_heap.data();
+        const size_t size  = m_heap.size();
+        Entry        entry = std::move(data[index]);
+
+        while(true)
+        {
+            size_t first = index * D + 1;
+
+            if(first >= size)
+                break;
+
+            size_t last = first + D < size ? first + D : size;
+            size_t best = first;
+
+            for(size_t child = first + 1; child < last; child++)
+            {
+                if(m_fn(data[child].key, data[best].key))
+                    best = child;
+            }
+
+            if(!m_fn(data[best].key, entry.key))
+                break;
+
+            data[index] = std::move(data[best]);
+            m_position[data[index].id] = index;
+
+            index = best;
+        }
+
+        data[index] = std::move(entry);
+        m_position[data[index].id] = index;
+    }
+};
+
+// push/pop and decrease_key throughput of every heap against std::priority_queue
+void heap_bench(const size_t target)
+{
+    using namespace std::chrono;
+
+    std::mt19937_64 rng(42);
+
+    for(size_t size = 1024; size <= target; size *= 16)
+    {
+        std::vector<uint64_t> keys(size);
+
+        for(auto &key : keys)
+            key = rng();
+
+        auto rate = [&](auto fn)
+        {
+            auto start = steady_clock::now();
+            uint64_t check = fn();
+            auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+            // keeps the work from being optimized out
+            if(check == 1)
+                std::cout << ' ';
+
+            return size_t(double(size) / elapsed);
+        };
+
+        auto push_pop = [&](auto heap)
+        {
+            return rate([&]
+            {
+                uint64_t sum = 0;
+
+                for(auto key : keys)
+                    heap.push(key);
+
+                while(!heap.empty())
+                {
+                    sum += heap.top();
+                    heap.pop();
+                }
+
+                return sum;
+            });
+        };
+
+        size_t stl     = push_pop(std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<>>());
+        size_t binary  = push_pop(BinaryHeap<uint64_t>());
+        size_t quad    = push_pop(DHeap<uint64_t>());
+        size_t pairing = rate([&]
+        {
+            PairingHeap<uint64_t> heap;
+            uint64_t sum = 0;
+
+            for(auto key : keys)
+                heap.push(key);
+
+            while(!heap.empty())
+            {
+                sum += heap.top();
+                heap.pop();
+            }
+
+            return sum;
+        });
+        size_t indexed = rate([&]
+        {
+            IndexedHeap<uint64_t> heap(size);
+            uint64_t sum = 0;
+
+            for(size_t i = 0; i < size; i++)
+                heap.push(i, keys[i]);
+
+            while(!heap.empty())
+            {
+                sum += heap.top_key();
+                heap.pop();
+            }
+
+            return sum;
+        });
+
+        // halves every key once, in random order
+        std::vector<size_t> order(size);
+
+        for(size_t i = 0; i < size; i++)
+            order[i] = i;
+
+        std::shuffle(order.begin(), order.end(), rng);
+
+        size_t pairing_decrease;
+        size_t indexed_decrease;
+
+        {
+            PairingHeap<uint64_t> heap;
+            std::vector<PairingHeap<uint64_t>::Node*> nodes(size);
+
+            for(size_t i = 0; i < size; i++)
+                nodes[i] = heap.push(keys[i]);
+
+            pairing_decrease = rate([&]
+            {
+                for(size_t i : order)
+                    heap.decrease_key(nodes[i], keys[i] / 2);
+
+                return heap.top();
+            });
+        }
+
+        {
+            IndexedHeap<uint64_t> heap(size);
+
+            for(size_t i = 0; i < size; i++)
+                heap.push(i, keys[i]);
+
+            indexed_decrease = rate([&]
+            {
+                for(size_t i : order)
+                    heap.decrease_key(i, keys[i] / 2);
+
+                return heap.top_key();
+            });
+        }
+
+        std::cout
+                << size << " items, push+pop/s\n"
+                << "  std::priority_queue: " << stl     << '\n'
+                << "  BinaryHeap:          " << binary  << '\n'
+                << "  DHeap<4>:            " << quad    << '\n'
+                << "  PairingHeap:         " << pairing << '\n'
+                << "  IndexedHeap:         " << indexed << '\n'
+                << "decrease_key/s\n"
+                << "  PairingHeap:         " << pairing_decrease << '\n'
+                << "  IndexedHeap:         " << indexed_decrease << '\n';
+    }
+}
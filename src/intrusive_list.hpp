@@ -0,0 +1,620 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+// intrusive lists, the links live in a hook inside the user's type so linking never allocates or copies,
+// an object can sit in several lists at once through several hooks and it has to outlive its time in a list
+// a hook that is copied starts out unlinked, a copy of an object in a list is not in the list
+//
+// struct Request
+// {
+//     ListHook lru;
+//     ListHook timer;
+// };
+//
+// IntrusiveList<Request, &Request::lru> lru;
+
+// links for IntrusiveList
+struct ListHook
+{
+    ListHook *prev = nullptr;
+    ListHook *next = nullptr;
+
+    ListHook() = default;
+    ListHook(const ListHook&) {}
+    ListHook& operator=(const ListHook&) { return *this; }
+
+    [[nodiscard]]
+    bool linked() const { return next != nullptr; }
+};
+
+// link for IntrusiveForwardList
+struct ForwardListHook
+{
+    ForwardListHook *next = nullptr;
+
+    ForwardListHook() = default;
+    ForwardListHook(const ForwardListHook&) {}
+    ForwardListHook& operator=(const ForwardListHook&) { return *this; }
+
+    [[nodiscard]]
+    bool linked() const { return next != nullptr; }
+
+    // the last item of a list points here instead of at null so a linked hook always has a next
+    static ForwardListHook* last()
+    {
+        static ForwardListHook hook;
+        return &hook;
+    }
+};
+
+namespace intrusive
+{
+    // the object a hook is embedded in, the same arithmetic as offsetof
+    template<class T, class Hook, Hook T::*Member>
+    inline T* owner(Hook *hook)
+    {
+        const size_t offset = reinterpret_cast<size_t>(&(reinterpret_cast<T*>(alignof(T))->*Member)) - alignof(T);
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - offset);
+    }
+}
+
+// circular doubly linked list around a sentinel hook, every operation but clear is O(1)
+template<class T, ListHook T::*Member>
+class IntrusiveList
+{
+public:
+
+    class Iterator;
+
+    IntrusiveList()
+    {
+        m_root.prev = &m_root;
+        m_root.next = &m_root;
+    }
+
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    IntrusiveList(IntrusiveList&& other) noexcept : IntrusiveList()
+    {
+        splice(end(), other);
+    }
+
+    IntrusiveList& operator=(IntrusiveList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+            splice(end(), other);
+        }
+
+        return *this;
+    }
+
+    // leaves the items unlinked, it never frees them
+    ~IntrusiveList()
+    {
+        clear();
+    }
+
+    void push_front(T& item) { link(&m_root, &(item.*Member)); }
+    void push_back(T& item)  { link(m_root.prev, &(item.*Member)); }
+
+    // links item right before position
+    void insert(Iterator position, T& item) { link(position.m_hook->prev, &(item.*Member)); }
+
+    void pop_front()
+    {
+        if(!empty())
+            unlink(m_root.next);
+    }
+
+    void pop_back()
+    {
+        if(!empty())
+            unlink(m_root.prev);
+    }
+
+    // unlinks the item in O(1), it has to be in this list
+    void erase(T& item)
+    {
+        unlink(&(item.*Member));
+    }
+
+    // returns the iterator after the erased item so a loop can keep going
+    Iterator erase(Iterator position)
+    {
+        ListHook *next = position.m_hook->next;
+
+        unlink(position.m_hook);
+
+        return Iterator(next);
+    }
+
+    // moves an item that is already in this list to the front, the usual touch in an LRU
+    void move_to_front(T& item)
+    {
+        ListHook *hook = &(item.*Member);
+
+        detach(hook);
+        attach(&m_root, hook);
+    }
+
+    void move_to_back(T& item)
+    {
+        ListHook *hook = &(item.*Member);
+
+        detach(hook);
+        attach(m_root.prev, hook);
+    }
+
+    // moves every item of other in front of position in O(1)
+    void splice(Iterator position, IntrusiveList& other)
+    {
+        if(&other == this || other.empty())
+            return;
+
+        ListHook *first = other.m_root.next;
+        ListHook *last  = other.m_root.prev;
+        ListHook *after = position.m_hook;
+        ListHook *prev  = after->prev;
+
+        prev->next  = first;
+        first->prev = prev;
+        last->next  = after;
+        after->prev = last;
+
+        m_size += other.m_size;
+
+        other.m_root.prev = &other.m_root;
+        other.m_root.next = &other.m_root;
+        other.m_size      = 0;
+    }
+
+    // moves one item of other in front of position
+    void splice(Iterator position, IntrusiveList& other, T& item)
+    {
+        ListHook *hook = &(item.*Member);
+
+        if(hook == position.m_hook)
+            return;
+
+        other.detach(hook);
+        other.m_size--;
+
+        attach(position.m_hook->prev, hook);
+        m_size++;
+    }
+
+    // unlinks every item fn returns true for, every item is unlinked while fn runs so fn may hand it to another list
+    // an item fn returns false for and leaves alone goes back where it was, fn must not touch the other items
+    // returns how many items left the list
+    template<typename FN>
+    size_t remove_if(FN fn)
+    {
+        size_t removed = 0;
+
+        for(ListHook *hook = m_root.next; hook != &m_root;)
+        {
+            ListHook *prev = hook->prev;
+            ListHook *next = hook->next;
+
+            unlink(hook);
+
+            bool remove = fn(*owner(hook));
+
+            if(!remove && !hook->linked())
+                link(prev, hook);
+            else
+                removed++;
+
+            hook = next;
+        }
+
+        return removed;
+    }
+
+    // unlinks every item
+    void clear()
+    {
+        ListHook *hook = m_root.next;
+
+        while(hook != &m_root)
+        {
+            ListHook *next = hook->next;
+
+            hook->prev = nullptr;
+            hook->next = nullptr;
+
+            hook = next;
+        }
+
+        m_root.prev = &m_root;
+        m_root.next = &m_root;
+        m_size      = 0;
+    }
+
+    [[nodiscard]]
+    T& front() { return empty() ? throw std::out_of_range("List is empty") : *owner(m_root.next); }
+
+    [[nodiscard]]
+    T& back() { return empty() ? throw std::out_of_range("List is empty") : *owner(m_root.prev); }
+
+    [[nodiscard]]
+    size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    bool empty() const { return m_size == 0; }
+
+    Iterator begin() { return Iterator(m_root.next); }
+    Iterator end()   { return Iterator(&m_root); }
+
+    // the position of an item that is in the list
+    Iterator iterator_to(T& item) { return Iterator(&(item.*Member)); }
+
+private:
+    ListHook m_root;
+    size_t   m_size = 0;
+
+    static inline T* owner(ListHook *hook) { return intrusive::owner<T, ListHook, Member>(hook); }
+
+    static inline void attach(ListHook *prev, ListHook *hook)
+    {
+        hook->prev       = prev;
+        hook->next       = prev->next;
+        prev->next->prev = hook;
+        prev->next       = hook;
+    }
+
+    static inline void detach(ListHook *hook)
+    {
+        hook->prev->next = hook->next;
+        hook->next->prev = hook->prev;
+    }
+
+    inline void link(ListHook *prev, ListHook *hook)
+    {
+        if(hook->linked())
+            throw std::logic_error("Item is already in a list");
+
+        attach(prev, hook);
+        m_size++;
+    }
+
+    inline void unlink(ListHook *hook)
+    {
+        detach(hook);
+
+        hook->prev = nullptr;
+        hook->next = nullptr;
+
+        m_size--;
+    }
+
+    friend class Iterator;
+};
+
+template<class T, ListHook T::*Member>
+class IntrusiveList<T, Member>::Iterator
+{
+public:
+    explicit Iterator(ListHook *hook) : m_hook(hook) {}
+
+    T& operator*() const { return *IntrusiveList::owner(m_hook); }
+    T* operator->() const { return IntrusiveList::owner(m_hook); }
+
+    Iterator& operator++()
+    {
+        m_hook = m_hook->next;
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator temp = *this;
+        m_hook = m_hook->next;
+        return temp;
+    }
+
+    Iterator& operator--()
+    {
+        m_hook = m_hook->prev;
+        return *this;
+    }
+
+    Iterator operator--(int)
+    {
+        Iterator temp = *this;
+        m_hook = m_hook->prev;
+        return temp;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_hook == b.m_hook; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_hook != b.m_hook; }
+
+private:
+    ListHook *m_hook;
+
+    friend class IntrusiveList;
+};
+
+// singly linked list with a tail pointer, pushing at either end, popping the front and splicing are O(1)
+// without a back link erasing an arbitrary item has to find its predecessor first
+template<class T, ForwardListHook T::*Member>
+class IntrusiveForwardList
+{
+public:
+
+    class Iterator;
+
+    IntrusiveForwardList() = default;
+
+    IntrusiveForwardList(const IntrusiveForwardList&) = delete;
+    IntrusiveForwardList& operator=(const IntrusiveForwardList&) = delete;
+
+    IntrusiveForwardList(IntrusiveForwardList&& other) noexcept
+    {
+        splice_back(other);
+    }
+
+    IntrusiveForwardList& operator=(IntrusiveForwardList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+            splice_back(other);
+        }
+
+        return *this;
+    }
+
+    ~IntrusiveForwardList()
+    {
+        clear();
+    }
+
+    void push_front(T& item)
+    {
+        ForwardListHook *hook = &(item.*Member);
+
+        if(hook->linked())
+            throw std::logic_error("Item is already in a list");
+
+        hook->next = m_head ? m_head : ForwardListHook::last();
+        m_head     = hook;
+
+        if(!m_tail)
+            m_tail = hook;
+
+        m_size++;
+    }
+
+    void push_back(T& item)
+    {
+        ForwardListHook *hook = &(item.*Member);
+
+        if(hook->linked())
+            throw std::logic_error("Item is already in a list");
+
+        hook->next = ForwardListHook::last();
+
+        if(m_tail)
+            m_tail->next = hook;
+        else
+            m_head = hook;
+
+        m_tail = hook;
+        m_size++;
+    }
+
+    // links item right after position
+    void insert_after(Iterator position, T& item)
+    {
+        ForwardListHook *prev = position.m_hook;
+        ForwardListHook *hook = &(item.*Member);
+
+        if(hook->linked())
+            throw std::logic_error("Item is already in a list");
+
+        hook->next = prev->next;
+        prev->next = hook;
+
+        if(m_tail == prev)
+            m_tail = hook;
+
+        m_size++;
+    }
+
+    void pop_front()
+    {
+        if(empty())
+            return;
+
+        ForwardListHook *hook = m_head;
+
+        m_head     = hook->next == ForwardListHook::last() ? nullptr : hook->next;
+        hook->next = nullptr;
+
+        if(!m_head)
+            m_tail = nullptr;
+
+        m_size--;
+    }
+
+    // unlinks the item after position and returns the iterator to the one after that
+    Iterator erase_after(Iterator position)
+    {
+        ForwardListHook *prev = position.m_hook;
+        ForwardListHook *hook = prev->next;
+
+        prev->next = hook->next;
+        hook->next = nullptr;
+
+        if(m_tail == hook)
+            m_tail = prev;
+
+        m_size--;
+
+        return Iterator(prev->next);
+    }
+
+    // O(n), returns false if the item was not in the list
+    bool erase(T& item)
+    {
+        ForwardListHook *hook = &(item.*Member);
+
+        if(!hook->linked() || !m_head)
+            return false;
+
+        if(hook == m_head)
+        {
+            pop_front();
+            return true;
+        }
+
+        for(ForwardListHook *prev = m_head; prev != ForwardListHook::last(); prev = prev->next)
+        {
+            if(prev->next == hook)
+            {
+                erase_after(Iterator(prev));
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // moves every item of other to the back in O(1)
+    void splice_back(IntrusiveForwardList& other)
+    {
+        if(&other == this || other.empty())
+            return;
+
+        if(m_tail)
+            m_tail->next = other.m_head;
+        else
+            m_head = other.m_head;
+
+        m_tail  = other.m_tail;
+        m_size += other.m_size;
+
+        other.m_head = nullptr;
+        other.m_tail = nullptr;
+        other.m_size = 0;
+    }
+
+    // unlinks every item fn returns true for in one pass, every item is unlinked while fn runs so fn may hand it
+    // to another list, an item fn returns false for and leaves alone goes back where it was
+    // fn must not touch the other items, returns how many items left the list
+    template<typename FN>
+    size_t remove_if(FN fn)
+    {
+        size_t removed = 0;
+
+        // the last item kept so far, null while nothing is
+        ForwardListHook *prev = nullptr;
+        ForwardListHook *hook = m_head;
+
+        while(hook && hook != ForwardListHook::last())
+        {
+            ForwardListHook *next = hook->next;
+
+            if(prev)
+                erase_after(Iterator(prev));
+            else
+                pop_front();
+
+            bool remove = fn(*owner(hook));
+
+            if(!remove && !hook->linked())
+            {
+                if(prev)
+                    insert_after(Iterator(prev), *owner(hook));
+                else
+                    push_front(*owner(hook));
+
+                prev = hook;
+            }
+            else
+            {
+                removed++;
+            }
+
+            hook = next;
+        }
+
+        return removed;
+    }
+
+    void clear()
+    {
+        while(m_head)
+        {
+            ForwardListHook *next = m_head->next;
+
+            m_head->next = nullptr;
+            m_head       = next == ForwardListHook::last() ? nullptr : next;
+        }
+
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+    [[nodiscard]]
+    T& front() { return m_head ? *owner(m_head) : throw std::out_of_range("List is empty"); }
+
+    [[nodiscard]]
+    T& back() { return m_tail ? *owner(m_tail) : throw std::out_of_range("List is empty"); }
+
+    [[nodiscard]]
+    size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    bool empty() const { return m_size == 0; }
+
+    Iterator begin() { return Iterator(m_head ? m_head : ForwardListHook::last()); }
+    Iterator end()   { return Iterator(ForwardListHook::last()); }
+
+private:
+    ForwardListHook *m_head = nullptr;
+    ForwardListHook *m_tail = nullptr;
+    size_t           m_size = 0;
+
+    static inline T* owner(ForwardListHook *hook) { return intrusive::owner<T, ForwardListHook, Member>(hook); }
+
+    friend class Iterator;
+};
+
+template<class T, ForwardListHook T::*Member>
+class IntrusiveForwardList<T, Member>::Iterator
+{
+public:
+    explicit Iterator(ForwardListHook *hook) : m_hook(hook) {}
+
+    T& operator*() const { return *IntrusiveForwardList::owner(m_hook); }
+    T* operator->() const { return IntrusiveForwardList::owner(m_hook); }
+
+    Iterator& operator++()
+    {
+        m_hook = m_hook->next;
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator temp = *this;
+        m_hook = m_hook->next;
+        return temp;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_hook == b.m_hook; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_hook != b.m_hook; }
+
+private:
+    ForwardListHook *m_hook;
+
+    friend class IntrusiveForwardList;
+};
@@ -6,6 +6,8 @@
 #include <list>
 #include <optional>
 #include <initializer_list>
+#include <tuple>
+#include <utility>
 
 #include "record.hpp"
 
@@ -80,23 +82,72 @@ public:
         return !m_size;
     }
 
+    // the record is built straight in its list node, key and value are moved or copied in exactly once
     Record<K, V>& set(K &&key, V &&value)
     {
-        Record<K, V> item(std::forward<K>(key), std::forward<V>(value));
-        return set_item(item);
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::move(value)));
     }
 
     Record<K, V>& set(const K &key, V &&value)
     {
-        Record<K, V> item(key, value);
-        return set_item(item);
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value)));
     }
 
+    Record<K, V>& set(const K &key, const V &value)
+    {
+        return emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value));
+    }
+
+    // a takes any Record constructor's arguments, including the piecewise one
     template<class ...A>
     Record<K, V>& emplace(A &&...a)
     {
-        Record<K, V> item(a...);
-        return set_item(item);
+        return emplace_item(std::forward<A>(a)...);
+    }
+
+    // the value is constructed from a only if key is not there yet, otherwise nothing is touched
+    // returns the record with the key and whether it was inserted
+    template<class ...A>
+    std::pair<Record<K, V>&, bool> try_emplace(const K &key, A &&...a)
+    {
+        if (Record<K, V> *item = search_record(key))
+            return { *item, false };
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<A>(a)...)), true };
+    }
+
+    template<class ...A>
+    std::pair<Record<K, V>&, bool> try_emplace(K &&key, A &&...a)
+    {
+        if (Record<K, V> *item = search_record(key))
+            return { *item, false };
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<A>(a)...)), true };
+    }
+
+    // assigns value to the key if it is there and inserts it if not, returns whether it was inserted
+    template<class M>
+    std::pair<Record<K, V>&, bool> insert_or_assign(const K &key, M &&value)
+    {
+        if (Record<K, V> *item = search_record(key))
+        {
+            item->value = std::forward<M>(value);
+            return { *item, false };
+        }
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<M>(value))), true };
+    }
+
+    template<class M>
+    std::pair<Record<K, V>&, bool> insert_or_assign(K &&key, M &&value)
+    {
+        if (Record<K, V> *item = search_record(key))
+        {
+            item->value = std::forward<M>(value);
+            return { *item, false };
+        }
+
+        return { emplace_item(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<M>(value))), true };
     }
 
     V* get(const K &key) const
@@ -106,12 +157,7 @@ public:
 
     V& operator[](const K &key)
     {
-        V *value = search(key);
-
-        if (!value)
-            return set(key, V()).value;
-
-        return *value;
+        return try_emplace(key).first.value;
     }
 
     V& get(const K &key, const V &def_value) const
@@ -128,8 +174,8 @@ public:
 
         for (auto &item : m_bucket[h])
         {
-            if (item->key == key)
-                output.push_back(&item->value);
+            if (item.key == key)
+                output.push_back(&item.value);
         }
 
         return output;
@@ -148,7 +194,7 @@ public:
 
         for (auto it = chain.begin(); it != chain.end(); it++)
         {
-            if ((*it)->key == key)
+            if (it->key == key)
             {
                 chain.erase(it);
                 m_size--;
@@ -183,16 +229,21 @@ private:
     Chain *m_bucket{};
     std::hash<K> m_hash;
 
-    Record<K, V>& set_item(Record<K, V> &item)
+    // the record is constructed in a node of its own which is then linked into its chain, so it never moves
+    template<class ...A>
+    Record<K, V>& emplace_item(A &&...a)
     {
+        Chain node;
+        Record<K, V> &item = node.emplace_back(std::forward<A>(a)...);
+
         if (++m_size >= m_capacity)
             rehash();
 
-        size_t h = hash(item.key);
+        Chain &chain = m_bucket[hash(item.key)];
 
-        Chain &chain = m_bucket[h];
+        chain.splice(chain.end(), node);
 
-        return chain.emplace_back(std::move(item));;
+        return item;
     }
 
     constexpr inline
@@ -201,18 +252,24 @@ private:
         return m_hash(k) % m_capacity;
     }
 
-    V* search(const K &key) const
+    Record<K, V>* search_record(const K &key) const
     {
         size_t h = hash(key);
 
         for (auto &record : m_bucket[h])
         {
             if (record.key == key)
-                return &record.value;
+                return &record;
         }
         return nullptr;
     }
 
+    V* search(const K &key) const
+    {
+        Record<K, V> *record = search_record(key);
+        return record ? &record->value : nullptr;
+    }
+
     inline void construct(int n)
     {
         m_capacity = n;
@@ -232,24 +289,15 @@ private:
 
         size_t i;
 
+        // the nodes are relinked into their new chains, no record is copied or moved
         for (i = 0; i < n; i++)
         {
-            //temp[i] = Chain();
-
             Chain &old = m_bucket[i];
 
-            if (old.empty())
-                continue;
-
-            for (auto &record : old)
+            while (!old.empty())
             {
-                size_t h = hash(record.key);
-                Chain &chain = temp[h];
-
-                // if (!chain)
-                //     temp[h] = Chain();
-
-                chain.push_back(record);
+                Chain &chain = temp[hash(old.front().key)];
+                chain.splice(chain.end(), old, old.begin());
             }
         }
 
@@ -1,34 +1,734 @@
 #pragma once
 
 #include <cstdint>
+#include <cmath>
+#include <memory>
+#include <bit>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <iostream>
+#include <concepts>
+#include <optional>
+#include <type_traits>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "util.hpp"
+#include "array.hpp"
+#include "bitset.hpp"
+#include "common.hpp"
+#include "sieve.hpp"
+#include "simd.hpp"
 
 namespace dna
 {
-    // implementation of Euclid's GCD algorithm
-    uint32_t gcd(size_t a, size_t b)
+    template<typename T>
+    concept is_unsigned_word = std::unsigned_integral<T> || std::same_as<T, unsigned __int128>;
+
+    template<typename T>
+    concept is_signed_word = std::signed_integral<T> || std::same_as<T, __int128>;
+
+    // std::countr_zero does not take 128 bit integers
+    template<is_unsigned_word T>
+    constexpr int countr_zero(T x)
     {
-        if(a < b)
+        if constexpr(sizeof(T) > 8)
         {
-            size_t temp = a;
-            a = b;
-            b = temp;
+            uint64_t low = uint64_t(x);
+            return low ? std::countr_zero(low) : 64 + std::countr_zero(uint64_t(x >> 64));
         }
+        else
+        {
+            return std::countr_zero(x);
+        }
+    }
 
-        size_t r = a % b;
-
-        if(r == 0)
+    // implementation of Stein's binary GCD algorithm, the result has the width of the arguments
+    template<is_unsigned_word T>
+    constexpr T gcd(T a, T b)
+    {
+        if(a == 0)
             return b;
+        if(b == 0)
+            return a;
+
+        int shift = countr_zero(T(a | b));
 
-        while(r > 0)
+        a >>= countr_zero(a);
+
+        do
         {
+            b >>= countr_zero(b);
+
+            if(a > b)
+            {
+                T temp = a;
+                a = b;
+                b = temp;
+            }
+
+            b -= a;
+        }
+        while(b != 0);
+
+        return a << shift;
+    }
+
+    template<is_signed_word T>
+    struct unsigned_word { using type = std::make_unsigned_t<T>; };
+
+    template<>
+    struct unsigned_word<__int128> { using type = unsigned __int128; };
+
+    template<is_signed_word T>
+    constexpr auto gcd(T a, T b)
+    {
+        using U = typename unsigned_word<T>::type;
+
+        U x = a < 0 ? U(0) - U(a) : U(a);
+        U y = b < 0 ? U(0) - U(b) : U(b);
+
+        return gcd(x, y);
+    }
+
+    // 0 when either argument is 0
+    template<is_unsigned_word T>
+    constexpr T lcm(T a, T b)
+    {
+        if(a == 0 || b == 0)
+            return 0;
+
+        return a / gcd(a, b) * b;
+    }
+
+    template<is_signed_word T>
+    struct Bezout
+    {
+        T gcd;
+        T x;
+        T y;
+    };
+
+    // extended euclid, returns gcd(a, b) along with x and y such that a*x + b*y = gcd(a, b)
+    template<is_signed_word T>
+    constexpr Bezout<T> extended_gcd(T a, T b)
+    {
+        T x = 1, next_x = 0;
+        T y = 0, next_y = 1;
+
+        while(b != 0)
+        {
+            T q = a / b;
+            T r = a - q * b;
+
             a = b;
             b = r;
-            r = a % b;
+
+            T temp = x - q * next_x;
+            x = next_x;
+            next_x = temp;
+
+            temp = y - q * next_y;
+            y = next_y;
+            next_y = temp;
+        }
+
+        if(a < 0)
+            return { -a, -x, -y };
+
+        return { a, x, y };
+    }
+
+    // the inverse of a modulo m, empty when a and m are not coprime
+    template<is_unsigned_word T>
+    requires (sizeof(T) <= 8)
+    constexpr std::optional<T> mod_inverse(T a, T m)
+    {
+        if(m == 0)
+            return std::nullopt;
+
+        // the coefficients stay below m in magnitude so 128 bits always hold them
+        auto [g, x, y] = extended_gcd<__int128>(a % m, m);
+
+        if(g != 1)
+            return std::nullopt;
+
+        return T(x < 0 ? x + m : x);
+    }
+
+    // the batch gcd lanes, compiled for their instruction set whatever the build targets and picked at runtime
+    // each one does the whole registers it can and returns how many pairs that was, the caller finishes the rest
+
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+    namespace avx2
+    {
+        // the lowest set bit converted to float has its index in the exponent
+        inline __m256i ctz(__m256i x)
+        {
+            __m256i low  = _mm256_and_si256(x, _mm256_sub_epi32(_mm256_setzero_si256(), x));
+            __m256i bits = _mm256_castps_si256(_mm256_cvtepi32_ps(low));
+
+            return _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127));
+        }
+
+        inline size_t gcd(const uint32_t *a, const uint32_t *b, uint32_t *output, size_t count)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+
+            size_t i = 0;
+
+            for(; i + 8 <= count; i += 8)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+                // a zero on either side is settled at the end, the lane starts out finished
+                __m256i trivial = _mm256_or_si256(_mm256_cmpeq_epi32(x, zero), _mm256_cmpeq_epi32(y, zero));
+                __m256i shift   = ctz(_mm256_or_si256(x, y));
+
+                __m256i u = _mm256_srlv_epi32(x, ctz(x));
+                __m256i v = _mm256_andnot_si256(trivial, y);
+
+                while(!_mm256_testz_si256(v, v))
+                {
+                    __m256i done = _mm256_cmpeq_epi32(v, zero);
+
+                    v = _mm256_srlv_epi32(v, ctz(v));
+
+                    __m256i lo = _mm256_min_epu32(u, v);
+                    __m256i hi = _mm256_max_epu32(u, v);
+
+                    u = _mm256_blendv_epi8(lo, u, done);
+                    v = _mm256_andnot_si256(done, _mm256_sub_epi32(hi, lo));
+                }
+
+                __m256i result = _mm256_blendv_epi8(_mm256_sllv_epi32(u, shift), _mm256_or_si256(x, y), trivial);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), result);
+            }
+
+            return i;
+        }
+    }
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512cd")
+    namespace avx512
+    {
+        inline __m512i ctz(__m512i x)
+        {
+            __m512i low = _mm512_and_si512(x, _mm512_sub_epi64(_mm512_setzero_si512(), x));
+            return _mm512_sub_epi64(_mm512_set1_epi64(63), _mm512_lzcnt_epi64(low));
+        }
+
+        // only masked forms are used, the unmasked min/max/shifts start from an uninitialized register
+        // that gcc warns about, here every lane comes from a source or from zero
+        inline size_t gcd(const uint64_t *a, const uint64_t *b, uint64_t *output, size_t count)
+        {
+            const __m512i zero = _mm512_setzero_si512();
+
+            size_t i = 0;
+
+            for(; i + 8 <= count; i += 8)
+            {
+                __m512i x = _mm512_loadu_si512(a + i);
+                __m512i y = _mm512_loadu_si512(b + i);
+
+                __mmask8 trivial = _mm512_cmpeq_epu64_mask(x, zero) | _mm512_cmpeq_epu64_mask(y, zero);
+                __mmask8 active  = __mmask8(~trivial);
+                __m512i  shift   = ctz(_mm512_or_si512(x, y));
+
+                __m512i u = _mm512_maskz_srlv_epi64(active, x, ctz(x));
+                __m512i v = _mm512_maskz_mov_epi64(active, y);
+
+                for(__mmask8 open = _mm512_test_epi64_mask(v, v); open; open = _mm512_test_epi64_mask(v, v))
+                {
+                    __m512i odd = _mm512_maskz_srlv_epi64(open, v, ctz(v));
+                    __m512i hi  = _mm512_maskz_max_epu64(open, u, odd);
+
+                    u = _mm512_mask_min_epu64(u, open, u, odd);
+                    v = _mm512_maskz_sub_epi64(open, hi, u);
+                }
+
+                __m512i result = _mm512_mask_sllv_epi64(_mm512_or_si512(x, y), active, u, shift);
+
+                _mm512_storeu_si512(output + i, result);
+            }
+
+            return i;
         }
+    }
+#pragma GCC pop_options
+#endif
+
+    // gcd of a[i] and b[i] for every i, the lanes run stein's algorithm side by side
+    // until the slowest pair in the register finishes
+    inline void gcd(const uint32_t *a, const uint32_t *b, uint32_t *output, size_t count)
+    {
+        size_t i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+        if(simd::level() != simd::Level::Base)
+            i = avx2::gcd(a, b, output, count);
+#endif
+
+        for(; i < count; i++)
+            output[i] = gcd(a[i], b[i]);
+    }
+
+    inline void gcd(const uint64_t *a, const uint64_t *b, uint64_t *output, size_t count)
+    {
+        size_t i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+        // simd::level() does not look for the conflict detection extension lzcnt comes from
+        static const bool lzcnt = simd::level() == simd::Level::AVX512 && __builtin_cpu_supports("avx512cd");
+
+        if(lzcnt)
+            i = avx512::gcd(a, b, output, count);
+#endif
 
-        return b;
+        for(; i < count; i++)
+            output[i] = gcd(a[i], b[i]);
+    }
+
+    // arithmetic modulo an odd 64 bit number in montgomery form, values are kept as x * 2^64 mod n
+    class Montgomery
+    {
+    public:
+
+        Montgomery() = default;
+
+        explicit Montgomery(uint64_t n) : m_n(n)
+        {
+            // newton iteration doubles the correct low bits of n^-1 mod 2^64 every step
+            m_inv = n;
+
+            for(int i = 0; i < 5; i++)
+                m_inv *= 2 - n * m_inv;
+
+            // 2^64 mod n without a 128 bit division
+            m_one = (0 - n) % n;
+            m_r2  = uint64_t((unsigned __int128)m_one * m_one % n);
+        }
+
+        inline uint64_t reduce(unsigned __int128 t) const
+        {
+            // the low halves of t and m * n cancel so only the high halves are subtracted
+            uint64_t m  = uint64_t(t) * m_inv;
+            uint64_t hi = uint64_t(t >> 64);
+            uint64_t mn = uint64_t(((unsigned __int128)m * m_n) >> 64);
+
+            return hi >= mn ? hi - mn : hi - mn + m_n;
+        }
+
+        inline uint64_t to(uint64_t x) const { return reduce((unsigned __int128)(x % m_n) * m_r2); }
+
+        inline uint64_t from(uint64_t x) const { return reduce(x); }
+
+        inline uint64_t mul(uint64_t a, uint64_t b) const { return reduce((unsigned __int128)a * b); }
+
+        inline uint64_t add(uint64_t a, uint64_t b) const { return a >= m_n - b ? a - (m_n - b) : a + b; }
+
+        uint64_t pow(uint64_t base, uint64_t exponent) const
+        {
+            uint64_t result = m_one;
+
+            for(; exponent; exponent >>= 1)
+            {
+                if(exponent & 1)
+                    result = mul(result, base);
+                base = mul(base, base);
+            }
+
+            return result;
+        }
+
+        [[nodiscard]]
+        inline uint64_t one() const { return m_one; }
+
+        // n - 1 in montgomery form
+        [[nodiscard]]
+        inline uint64_t minus_one() const { return m_n - m_one; }
+
+        [[nodiscard]]
+        inline uint64_t modulus() const { return m_n; }
+
+    private:
+        uint64_t m_n   = 1;
+        uint64_t m_inv = 1;
+        uint64_t m_one = 0;
+        uint64_t m_r2  = 0;
+    };
+
+    // sieve of eratosthenes over [0, Limit) at compile time, the table size has to be known before the table is built
+    template<size_t Limit>
+    consteval Array<bool, Limit> composite_below()
+    {
+        static_assert(Limit > 2);
+
+        Array<bool, Limit> composite;
+
+        composite[0] = true;
+        composite[1] = true;
+
+        for(size_t i = 2; i * i < Limit; i++)
+        {
+            if(composite[i])
+                continue;
+
+            for(size_t j = i * i; j < Limit; j += i)
+                composite[j] = true;
+        }
+
+        return composite;
+    }
+
+    template<size_t Limit>
+    consteval size_t primes_below()
+    {
+        return container::count(composite_below<Limit>(), false);
+    }
+
+    // the primes below Limit in order, built by the compiler
+    //
+    //     static constexpr auto small = dna::prime_table<100>();
+    template<size_t Limit>
+    consteval Array<uint64_t, primes_below<Limit>()> prime_table()
+    {
+        auto composite = composite_below<Limit>();
+
+        Array<uint64_t, primes_below<Limit>()> primes;
+        size_t count = 0;
+
+        for(size_t i = 0; i < Limit; i++)
+        {
+            if(!composite[i])
+                primes[count++] = i;
+        }
+
+        return primes;
+    }
+
+    // reflected crc-32 as used by zip and ethernet, the byte table is built by the compiler
+    consteval Array<uint32_t, 256> crc32_make_table()
+    {
+        Array<uint32_t, 256> table;
+
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+
+            for(int bit = 0; bit < 8; bit++)
+                crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+
+            table[i] = crc;
+        }
+
+        return table;
+    }
+
+    static constexpr Array<uint32_t, 256> crc32_table = crc32_make_table();
+
+    // pass the previous result as crc to continue a checksum over data that comes in pieces
+    constexpr uint32_t crc32(std::string_view data, uint32_t crc = 0)
+    {
+        crc = ~crc;
+
+        for(char c : data)
+            crc = crc32_table.data()[(crc ^ uint8_t(c)) & 0xff] ^ (crc >> 8);
+
+        return ~crc;
+    }
+
+    // these bases make miller-rabin exact for every 64 bit number
+    static constexpr uint64_t miller_rabin_bases[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+    // settles small numbers and anything with a small factor, returns -1 when miller-rabin has to decide
+    inline int trial_division(uint64_t n)
+    {
+        static constexpr auto small = prime_table<41>();
+
+        if(n < 2)
+            return 0;
+
+        for(uint64_t p : small)
+        {
+            if(n == p)
+                return 1;
+            if(n % p == 0)
+                return 0;
+        }
+
+        return n < 41 * 41 ? 1 : -1;
+    }
+
+    // strong probable prime test of n = d * 2^s + 1 to a base already in montgomery form
+    inline bool strong_probable_prime(const Montgomery &mont, uint64_t x, uint64_t s)
+    {
+        if(x == mont.one() || x == mont.minus_one())
+            return true;
+
+        for(uint64_t i = 1; i < s; i++)
+        {
+            x = mont.mul(x, x);
+
+            if(x == mont.minus_one())
+                return true;
+            if(x == mont.one())
+                return false;
+        }
+
+        return false;
+    }
+
+    inline bool miller_rabin(const Montgomery &mont, size_t first_base = 0)
+    {
+        uint64_t n = mont.modulus();
+        uint64_t s = std::countr_zero(n - 1);
+        uint64_t d = (n - 1) >> s;
+
+        for(size_t i = first_base; i < std::size(miller_rabin_bases); i++)
+        {
+            uint64_t a = miller_rabin_bases[i] % n;
+
+            if(a == 0)
+                continue;
+
+            if(!strong_probable_prime(mont, mont.pow(mont.to(a), d), s))
+                return false;
+        }
+
+        return true;
+    }
+
+    // deterministic primality test for 64 bit numbers
+    inline bool is_prime(uint64_t n)
+    {
+        int small = trial_division(n);
+        return small >= 0 ? small : miller_rabin(Montgomery(n));
+    }
+
+    // base 2 in lockstep over four numbers so their multiplications overlap, only the ones that pass it try the other bases
+    inline void miller_rabin_lanes(const uint64_t *numbers, bool *output, const size_t *lane_index)
+    {
+        constexpr size_t lanes = 4;
+
+        Montgomery mont[lanes];
+
+        uint64_t d[lanes];
+        uint64_t s[lanes];
+        uint64_t x[lanes];
+        uint64_t two[lanes];
+        int      bits = 0;
+
+        for(size_t l = 0; l < lanes; l++)
+        {
+            uint64_t n = numbers[lane_index[l]];
+
+            mont[l] = Montgomery(n);
+            s[l]    = std::countr_zero(n - 1);
+            d[l]    = (n - 1) >> s[l];
+            x[l]    = mont[l].one();
+            two[l]  = mont[l].add(mont[l].one(), mont[l].one());
+            bits    = std::max(bits, int(std::bit_width(d[l])));
+        }
+
+        for(int bit = bits - 1; bit >= 0; bit--)
+        {
+            for(size_t l = 0; l < lanes; l++)
+            {
+                x[l] = mont[l].mul(x[l], x[l]);
+
+                if((d[l] >> bit) & 1)
+                    x[l] = mont[l].mul(x[l], two[l]);
+            }
+        }
+
+        for(size_t l = 0; l < lanes; l++)
+            output[lane_index[l]] = strong_probable_prime(mont[l], x[l], s[l]) && miller_rabin(mont[l], 1);
+    }
+
+    // tests count numbers at once, trial division settles most of them
+    // and the rest are queued up so miller-rabin always runs on four at a time
+    inline void is_prime(const uint64_t *numbers, bool *output, size_t count)
+    {
+        size_t waiting[4];
+        size_t queued = 0;
+
+        for(size_t i = 0; i < count; i++)
+        {
+            int small = trial_division(numbers[i]);
+
+            output[i] = small > 0;
+
+            if(small >= 0)
+                continue;
+
+            waiting[queued++] = i;
+
+            if(queued == 4)
+            {
+                miller_rabin_lanes(numbers, output, waiting);
+                queued = 0;
+            }
+        }
+
+        for(size_t i = 0; i < queued; i++)
+            output[waiting[i]] = miller_rabin(Montgomery(numbers[waiting[i]]));
+    }
+
+    inline uint64_t isqrt(uint64_t x)
+    {
+        uint64_t r = std::sqrt(double(x));
+
+        while(r * r > x)
+            r--;
+        while((r + 1) * (r + 1) <= x)
+            r++;
+
+        return r;
+    }
+
+    inline uint64_t icbrt(uint64_t x)
+    {
+        uint64_t r = std::cbrt(double(x));
+
+        while(r * r * r > x)
+            r--;
+        while((r + 1) * (r + 1) * (r + 1) <= x)
+            r++;
+
+        return r;
+    }
+
+    // lehmer's formula for pi(x)
+    // pi is tabulated up to about x^(2/3) and phi(x, a) recurses down to a periodic table for the first 6 primes
+    class PrimeCounter
+    {
+    public:
+
+        explicit PrimeCounter(uint64_t x)
+        {
+            uint64_t cbrt  = icbrt(x);
+            // twice the square root guarantees the prime after sqrt(x) is in the table
+            uint64_t limit = std::max<uint64_t>({ 2 * isqrt(x) + 2, std::min<uint64_t>(cbrt * cbrt, 1 << 23), 1024 });
+
+            m_pi.resize(limit, 0);
+
+            SegmentedSieve(0, limit).for_each([this](size_t p)
+            {
+                m_pi[p] = 1;
+                m_primes.push_back(uint32_t(p));
+            });
+
+            for(size_t i = 1; i < limit; i++)
+                m_pi[i] += m_pi[i - 1];
+
+            build_phi_tables();
+        }
+
+        uint64_t pi(uint64_t x)
+        {
+            if(x < m_pi.size())
+                return m_pi[x];
+
+            uint64_t a = pi(isqrt(isqrt(x)));
+            uint64_t b = pi(isqrt(x));
+            uint64_t c = pi(icbrt(x));
+
+            int64_t sum = phi(x, a) + int64_t(b + a - 2) * int64_t(b - a + 1) / 2;
+
+            for(uint64_t i = a + 1; i <= b; i++)
+            {
+                uint64_t w = x / prime(i);
+
+                sum -= pi(w);
+
+                if(i > c)
+                    continue;
+
+                uint64_t bi = pi(isqrt(w));
+
+                for(uint64_t j = i; j <= bi; j++)
+                    sum -= pi(w / prime(j)) - (j - 1);
+            }
+
+            return sum;
+        }
+
+        // numbers in [1, x] that no prime up to the a-th divides
+        int64_t phi(uint64_t x, uint64_t a)
+        {
+            if(a <= wheel_primes)
+                return (x / m_product[a]) * m_totient[a] + m_phi[a][x % m_product[a]];
+
+            if(x < prime(a + 1))
+                return x > 0;
+
+            if(x < m_pi.size() && x < uint64_t(prime(a + 1)) * prime(a + 1))
+                return m_pi[x] - a + 1;
+
+            return phi(x, a - 1) - phi(x / prime(a), a - 1);
+        }
+
+    private:
+        static constexpr size_t wheel_primes = 6;
+
+        std::vector<uint32_t> m_pi;
+        std::vector<uint32_t> m_primes;
+
+        uint64_t              m_product[wheel_primes + 1];
+        uint64_t              m_totient[wheel_primes + 1];
+        std::vector<uint16_t> m_phi[wheel_primes + 1];
+
+        // 1 indexed so the formulas read like the paper
+        inline uint64_t prime(uint64_t i) const
+        {
+            return m_primes[i - 1];
+        }
+
+        // phi(x, a) for x below the product of the first a primes, the rest follows by periodicity
+        void build_phi_tables()
+        {
+            m_product[0] = 1;
+            m_totient[0] = 1;
+            m_phi[0]     = { 0 };
+
+            for(size_t a = 1; a <= wheel_primes; a++)
+            {
+                m_product[a] = m_product[a - 1] * prime(a);
+                m_totient[a] = m_totient[a - 1] * (prime(a) - 1);
+
+                m_phi[a].resize(m_product[a]);
+
+                uint16_t total = 0;
+
+                for(uint64_t r = 0; r < m_product[a]; r++)
+                {
+                    bool coprime = r > 0;
+
+                    for(size_t i = 1; i <= a && coprime; i++)
+                        coprime = r % prime(i) != 0;
+
+                    total += coprime;
+                    m_phi[a][r] = total;
+                }
+            }
+        }
+    };
+
+    // number of primes up to and including x
+    inline uint64_t prime_count(uint64_t x)
+    {
+        return PrimeCounter(x).pi(x);
     }
 }
 
@@ -41,6 +741,8 @@ public:
     {
         Eratosthenes,
         Sundaram,
+        // streams the range through a SegmentedSieve so only one batch of primes is held at a time
+        Segmented,
     };
 
     Prime(size_t start, size_t end, Sieve sieve)
@@ -51,6 +753,10 @@ public:
         {
             case Eratosthenes: m_primes = std::move(eratosthenes(start, end)); break;
             case Sundaram: m_primes = std::move(sundaram(start, end)); break;
+            case Segmented:
+                m_stream = std::make_unique<SegmentedSieve>(start, end);
+                refill();
+                break;
         }
     }
 
@@ -58,7 +764,13 @@ public:
     {
         if(m_offset >= m_primes.size())
             return npos;
-        return m_primes[m_offset++];
+
+        size_t prime = m_primes[m_offset++];
+
+        if(m_stream && m_offset == m_primes.size())
+            refill();
+
+        return prime;
     }
 
     inline bool good() const
@@ -66,27 +778,41 @@ public:
         return m_offset < m_primes.size();
     }
 
+    // the number of primes returned by next so far
     inline size_t offset() const
     {
-        return m_offset;
+        return m_consumed + m_offset;
     }
 
+    // in segmented mode this only holds the current batch
     inline const std::vector<size_t>& primes() const
     {
         return m_primes;
     }
 
-    static std::vector<size_t> sundaram(size_t start, size_t end)
+    static std::vector<size_t> segmented(size_t start, size_t end, size_t threads = 0)
     {
-        size_t k = (end-1)/2;
+        std::vector<size_t> output;
+        SegmentedSieve sieve(start, end, threads);
+
+        while(sieve.next_batch(output));
+
+        return output;
+    }
 
-        std::vector<bool> a;
+    // counts the primes in [start, end) without storing them
+    static size_t count(size_t start, size_t end, size_t threads = 0)
+    {
+        return SegmentedSieve(start, end, threads).count();
+    }
 
-        a.reserve(k+1);
+    static std::vector<size_t> sundaram(size_t start, size_t end)
+    {
+        size_t k = (end-1)/2;
 
-        fill_vec(a, true, k+1);
+        Bitset a(k+1, true);
 
-        a[0] = false;
+        a.reset(0);
 
         auto m = [](size_t i, size_t j) { return i + j + 2 * i * j; };
 
@@ -98,48 +824,42 @@ public:
 
             while(m(i, j) <= k)
             {
-                a[m(i, j)] = false;
+                a.reset(m(i, j));
                 j += 1;
             }
         }
 
         std::vector<size_t> output;
 
-        output.reserve(a.size());
-
-        for(size_t i = start; i < a.size(); i++)
-        {
-            if(a[i])
-                output.push_back(i);
-        }
+        output.reserve(a.count());
 
-        for(auto &item : output)
-            item = 2 * item + 1;
+        for(size_t i = a.find_next(start); i != npos; i = a.find_next(i + 1))
+            output.push_back(2 * i + 1);
 
         return output;
     }
 
     static std::vector<size_t> eratosthenes(size_t start, size_t end)
     {
-        std::vector<bool> a;
+        if(end < 2)
+            return {};
 
-        a.reserve(end);
+        Bitset a(end, true);
 
-        fill_vec(a, true, end);
-
-        a[1] = false;
+        a.reset(0);
+        a.reset(1);
 
         size_t target = std::sqrt(end);
 
         for(size_t i = 2; i <= target; i++)
         {
-            if(a[i])
+            if(a.test(i))
             {
-                size_t j = std::pow(i, 2);
+                size_t j = i * i;
 
                 while(j < end)
                 {
-                    a[j] = false;
+                    a.reset(j);
                     j = j+i;
                 }
             }
@@ -147,19 +867,75 @@ public:
 
         std::vector<size_t> output;
 
-        output.reserve(a.size());
+        output.reserve(a.count());
 
-        for(size_t i = start; i < end; i++)
-        {
-            if(a[i])
-                output.push_back(i);
-        }
+        for(size_t i = a.find_next(start); i != npos; i = a.find_next(i + 1))
+            output.push_back(i);
 
         return output;
     }
 
 private:
     std::vector<size_t> m_primes;
-    std::vector<bool> m_buff;
     size_t m_offset = 0;
-};
\ No newline at end of file
+    size_t m_consumed = 0;
+    std::unique_ptr<SegmentedSieve> m_stream;
+
+    // replaces the exhausted batch with the next one that has any primes in it
+    void refill()
+    {
+        m_consumed += m_offset;
+        m_offset = 0;
+        m_primes.clear();
+
+        while(m_primes.empty() && m_stream->next_batch(m_primes));
+    }
+};
+// compares the counting and primality paths in dna against the sieve path of Prime
+void prime_bench(const size_t x)
+{
+    using namespace std::chrono;
+
+    auto start = steady_clock::now();
+    size_t lehmer = dna::prime_count(x);
+    auto lehmer_time = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    size_t sieved = Prime::count(0, x + 1);
+    auto sieve_time = steady_clock::now() - start;
+
+    // primality of every odd number in a window just below x
+    const size_t window = 1 << 20;
+    const size_t low    = x > window * 2 ? x - window * 2 : 1;
+
+    std::vector<uint64_t> numbers;
+
+    for(size_t n = low | 1; n < low + window * 2; n += 2)
+        numbers.push_back(n);
+
+    std::unique_ptr<bool[]> results(new bool[numbers.size()]);
+
+    start = steady_clock::now();
+    dna::is_prime(numbers.data(), results.get(), numbers.size());
+    auto batch_time = steady_clock::now() - start;
+
+    size_t found = 0;
+
+    start = steady_clock::now();
+    for(uint64_t n : numbers)
+        found += dna::is_prime(n);
+    auto single_time = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    size_t window_sieved = Prime::count(low | 1, low + window * 2);
+    auto window_time = steady_clock::now() - start;
+
+    std::cout
+            << "pi(" << x << ")\n"
+            << "  lehmer:              " << lehmer << " in " << duration_cast<milliseconds>(lehmer_time) << '\n'
+            << "  segmented sieve:     " << sieved << " in " << duration_cast<milliseconds>(sieve_time) << '\n'
+            << "primes in a window of " << window * 2 << " below x\n"
+            << "  miller-rabin:        " << found << " in " << duration_cast<milliseconds>(single_time) << '\n'
+            << "  miller-rabin batch:  " << found << " in " << duration_cast<milliseconds>(batch_time) << '\n'
+            << "  segmented sieve:     " << window_sieved << " in " << duration_cast<milliseconds>(window_time) << '\n';
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "forward_list.hpp"
+#include "deque.hpp"
 
 // a lazy queue implementation
 template<class T>
@@ -10,28 +10,26 @@ public:
 
 	Queue() = default;
 
-	Queue(std::initializer_list<T> init_list) : m_list(init_list), m_size(init_list.size()) {}
+	Queue(std::initializer_list<T> init_list) : m_list(init_list) {}
 
 	void enqueue(T item)
 	{
-	    m_list.push_back(item);
-	    m_size++;
+	    m_list.push_back(std::move(item));
 	}
 
 	void dequeue()
 	{
-        m_list.pop();
-        m_size--;
+        m_list.pop_front();
 	}
 
 	bool empty() const
     {
-	    return m_size == 0;
+	    return m_list.empty();
     }
 
     size_t size() const
     {
-	    return m_size;
+	    return m_list.size();
     }
 
     T peek()
@@ -45,6 +43,5 @@ public:
     }
 
 private:
-	size_t m_size;
-	Forward_List<T> m_list;
+	Deque<T> m_list;
 };
\ No newline at end of file
@@ -1,13 +1,32 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <array>
+#include <span>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <iterator>
+#include <stdexcept>
+#include <chrono>
+#include <iostream>
+
 #include "util.hpp"
 #include "common.hpp"
+#include "vector.hpp"
 
 class range
 {
 public:
 
-    range(size_t start, size_t end, size_t step = 1) : m_start(start), m_end(end), m_step(step) {}
+    range(size_t start, size_t end, size_t step = 1) : m_start(start), m_end(end), m_step(step)
+    {
+        if(step == 0)
+            throw std::invalid_argument("Step can not be zero");
+    }
 
     class Range_iterator
     {
@@ -26,8 +45,15 @@ public:
         friend bool operator!=(const Range_iterator &a, const Range_iterator &b) { return a.m_current < b.m_current+1; }
     };
 
-    Range_iterator begin() { return Range_iterator(m_start, m_step); };
-    Range_iterator end() { return Range_iterator(m_end, m_step); }
+    Range_iterator begin() const { return Range_iterator(m_start, m_step); };
+    Range_iterator end() const { return Range_iterator(m_end, m_step); }
+
+    // the end is inclusive
+    size_t size() const { return m_start > m_end ? 0 : (m_end - m_start) / m_step + 1; }
+
+    bool empty() const { return size() == 0; }
+
+    size_t operator[](size_t index) const { return m_start + index * m_step; }
 
 private:
     size_t m_start;
@@ -35,41 +61,365 @@ private:
     size_t m_step;
 };
 
-template<is_container T>
+// lazy pipelines over a container, nothing runs until a terminal operation (each, sum, reduce, count, collect_into)
+// the source pushes every item through the stages, each stage is a lambda wrapping the next one so the
+// compiler inlines the whole chain into a single loop over the source, with no intermediate containers
+//
+//     auto total = Range(values).filter(is_even).transform(square).take(10).sum();
+//
+// a container given as an lvalue is borrowed and has to outlive the pipeline, a temporary is moved in and shared
+// by every stage built from it, items of a borrowed container can be modified through each
+
+namespace pipeline
+{
+    template<class C>
+    struct Borrowed
+    {
+        C *container;
+
+        template<class Sink>
+        void operator()(Sink &&sink) const
+        {
+            for(auto &&item : *container)
+            {
+                if(!sink(item))
+                    return;
+            }
+        }
+    };
+
+    template<class C>
+    struct Owned
+    {
+        std::shared_ptr<const C> container;
+
+        template<class Sink>
+        void operator()(Sink &&sink) const
+        {
+            for(auto &&item : *container)
+            {
+                if(!sink(item))
+                    return;
+            }
+        }
+    };
+
+    template<class C>
+    using reference_of = decltype(*std::begin(std::declval<C&>()));
+
+    // items that can be assigned through, what a borrowed non-const container yields
+    template<class R>
+    concept writable = std::is_lvalue_reference_v<R> && !std::is_const_v<std::remove_reference_t<R>>;
+}
+
+// G pushes the items into a sink that returns false to stop them coming, R is what it pushes,
+// an lvalue reference into the source or a value made by transform
+template<class G, class R>
 class Range
 {
 public:
+    using reference  = R;
+    using value_type = std::remove_cvref_t<R>;
+
+    explicit Range(G generate) : m_generate(std::move(generate)) {}
 
-    Range(T container) : container(container)
-    {}
+    template<is_container C>
+        requires std::is_same_v<G, pipeline::Borrowed<C>>
+    explicit Range(C &container) : m_generate{&container} {}
 
+    template<is_container C>
+        requires std::is_same_v<G, pipeline::Owned<C>>
+    explicit Range(C &&container) : m_generate{std::make_shared<const C>(std::move(container))} {}
+
+    // the items fn returns true for
     template<typename FN>
-    inline Range& map(FN fn)
+    auto filter(FN fn) const
     {
-        container::map(container, fn);
-        return *this;
+        return make<R>([generate = m_generate, fn](auto &&sink)
+        {
+            generate([&](R item) { return fn(item) ? sink(std::forward<R>(item)) : true; });
+        });
     }
 
+    // fn applied to every item, the results are not stored anywhere
     template<typename FN>
-    inline Range& each(FN fn)
+    auto transform(FN fn) const
     {
-        container::each(container, fn);
-        return *this;
+        using Out = decltype(fn(std::declval<R>()));
+
+        return make<Out>([generate = m_generate, fn](auto &&sink)
+        {
+            generate([&](R item) { return sink(fn(std::forward<R>(item))); });
+        });
+    }
+
+    // the first count items, the source is not read past them
+    auto take(size_t count) const
+    {
+        return make<R>([generate = m_generate, count](auto &&sink)
+        {
+            if(count == 0)
+                return;
+
+            size_t left = count;
+
+            generate([&](R item) { return sink(std::forward<R>(item)) && --left != 0; });
+        });
+    }
+
+    // every step-th item starting with the first
+    auto stride(size_t step) const
+    {
+        return make<R>([generate = m_generate, step](auto &&sink)
+        {
+            size_t skip = 0;
+
+            generate([&](R item)
+            {
+                if(skip)
+                {
+                    skip--;
+                    return true;
+                }
+
+                skip = step - 1;
+
+                return sink(std::forward<R>(item));
+            });
+        });
+    }
+
+    // (index, item) pairs
+    auto enumerate() const
+    {
+        using Out = std::pair<size_t, R>;
+
+        return make<Out>([generate = m_generate](auto &&sink)
+        {
+            size_t index = 0;
+
+            generate([&](R item) { return sink(Out(index++, std::forward<R>(item))); });
+        });
+    }
+
+    // (item, other item) pairs, stops at the end of the shorter one, other is borrowed
+    template<is_container C>
+    auto zip(C &other) const
+    {
+        using Out = std::pair<R, pipeline::reference_of<C>>;
+
+        return make<Out>([generate = m_generate, second = &other](auto &&sink)
+        {
+            auto current = std::begin(*second);
+            auto last    = std::end(*second);
+
+            if(!(current != last))
+                return;
+
+            generate([&](R item)
+            {
+                if(!sink(Out(std::forward<R>(item), *current)))
+                    return false;
+
+                ++current;
+
+                return current != last;
+            });
+        });
+    }
+
+    // groups of N items as a span over a buffer on the stack, the last group can be shorter
+    // the span is only valid until the next stage returns
+    template<size_t N>
+    auto chunk() const
+    {
+        static_assert(N > 0);
+
+        using Out = std::span<value_type>;
+
+        return make<Out>([generate = m_generate](auto &&sink)
+        {
+            std::array<value_type, N> buffer;
+            size_t count   = 0;
+            bool   stopped = false;
+
+            generate([&](R item)
+            {
+                buffer[count++] = std::forward<R>(item);
+
+                if(count < N)
+                    return true;
+
+                count   = 0;
+                stopped = !sink(Out(buffer.data(), N));
+
+                return !stopped;
+            });
+
+            if(count && !stopped)
+                sink(Out(buffer.data(), count));
+        });
     }
 
+    // runs the pipeline, fn gets every item
     template<typename FN>
-    inline Range& reduce(FN fn)
+    const Range& each(FN fn) const
     {
-        container::reduce(container, fn);
+        m_generate([&](R item)
+        {
+            fn(std::forward<R>(item));
+            return true;
+        });
+
         return *this;
     }
 
-    inline auto sum() const
+    // what the eager Range had, they run right away and write into the items so they need a borrowed source
+
+    // every item replaced by fn(item)
+    template<typename FN>
+        requires pipeline::writable<R>
+    const Range& map(FN fn) const
+    {
+        return each([&](R item) { item = fn(item); });
+    }
+
+    // every item after the first replaced by fn(first, item)
+    template<typename FN>
+        requires pipeline::writable<R>
+    const Range& reduce(FN fn) const
+    {
+        std::optional<value_type> first;
+
+        return each([&](R item)
+        {
+            if(first)
+                item = fn(*first, item);
+            else
+                first = item;
+        });
+    }
+
+    template<typename T, typename FN>
+    T reduce(T init, FN fn) const
+    {
+        m_generate([&](R item)
+        {
+            init = fn(std::move(init), std::forward<R>(item));
+            return true;
+        });
+
+        return init;
+    }
+
+    auto sum() const
+    {
+        return reduce(value_type(), [](value_type total, const value_type &item) { return total += item; });
+    }
+
+    size_t count() const
+    {
+        return reduce(size_t(0), [](size_t total, auto&&) { return total + 1; });
+    }
+
+    // the items in a new container, Out needs push_back
+    template<template<class...> class Out = Vector>
+    Out<value_type> collect_into() const
     {
-       return container::sum(container);
+        Out<value_type> output;
+        collect_into(output);
+        return output;
+    }
+
+    // appends the items to output
+    template<class Out>
+    Out& collect_into(Out &output) const
+    {
+        each([&](R item) { output.push_back(std::forward<R>(item)); });
+        return output;
     }
 
 private:
-    T container;
+    G m_generate;
+
+    template<class Out, class FN>
+    static Range<FN, Out> make(FN fn)
+    {
+        return Range<FN, Out>(std::move(fn));
+    }
 };
 
+template<is_container C>
+Range(C &container) -> Range<pipeline::Borrowed<C>, pipeline::reference_of<C>>;
+
+template<is_container C>
+    requires (!std::is_lvalue_reference_v<C>)
+Range(C &&container) -> Range<pipeline::Owned<C>, pipeline::reference_of<const C>>;
+
+// a filter, transform, take pipeline against the same written as a loop and as eager passes that store every stage
+void range_bench(const size_t items)
+{
+    using namespace std::chrono;
+
+    Vector<uint64_t> values;
+    values.reserve(items);
+
+    for(size_t i = 0; i < items; i++)
+        values.push_back(uint64_t(rand()));
+
+    auto odd    = [](uint64_t v) { return (v & 1) != 0; };
+    auto square = [](uint64_t v) { return v * v; };
+
+    size_t limit = items / 4 + 1;
+
+    auto start = steady_clock::now();
+
+    uint64_t loop = 0;
+    size_t   left = limit;
+
+    for(uint64_t v : values)
+    {
+        if(!odd(v))
+            continue;
+
+        loop += square(v);
+
+        if(--left == 0)
+            break;
+    }
+
+    auto loop_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+
+    Vector<uint64_t> kept;
+
+    for(uint64_t v : values)
+    {
+        if(odd(v))
+            kept.push_back(v);
+    }
+
+    container::map(kept, square);
+
+    Vector<uint64_t> first = kept.slice(0, limit < kept.size() ? limit : kept.size());
+
+    uint64_t eager = 0;
+
+    for(uint64_t v : first)
+        eager += v;
+
+    auto eager_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+
+    uint64_t lazy = Range(values).filter(odd).transform(square).take(limit).sum();
+
+    auto lazy_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    std::cout
+            << items << " items, filter transform take sum" << (loop == eager && loop == lazy ? "" : " MISMATCH") << '\n'
+            << "  loop:     " << loop_time * 1e9 / double(items) << " ns/item\n"
+            << "  eager:    " << eager_time * 1e9 / double(items) << " ns/item\n"
+            << "  pipeline: " << lazy_time * 1e9 / double(items) << " ns/item\n";
+}
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <stdexcept>
+#include <utility>
 
 // red-black tree implementation
 
@@ -38,6 +39,15 @@ public:
 
     RBT() = default;
 
+    // the nodes are owned by the tree, copying would free them twice
+    RBT(const RBT&) = delete;
+    RBT& operator=(const RBT&) = delete;
+
+    ~RBT()
+    {
+        destroy(m_root);
+    }
+
     Node* find_node(const K &key) const
     {
         Node *node = m_root;
@@ -83,12 +93,12 @@ public:
 
     inline V& min() const
     {
-        return min_node()->item;
+        return min_node()->value;
     }
 
     inline V& max() const
     {
-        return max_node()->item;
+        return max_node()->value;
     }
 
     V& find(const K &key) const
@@ -101,6 +111,12 @@ public:
         return node->value;
     }
 
+    [[nodiscard]]
+    size_t size() const
+    {
+        return m_node_count;
+    }
+
     void insert(const K &key, const V &value)
     {
         set_node(new Node
@@ -111,23 +127,75 @@ public:
         });
     }
 
-    void erase(const K &key)
+    void insert(const K &key, V &&value)
+    {
+        set_node(new Node
+        {
+            RBColor::Red,
+            key,
+            std::move(value)
+        });
+    }
+
+    // the value is constructed in the new node from a, only if key is not in the tree yet
+    // returns the node with the key and whether it was inserted
+    template<class ...A>
+    std::pair<Node*, bool> try_emplace(const K &key, A &&...a)
+    {
+        if (Node *node = find_node(key))
+            return { node, false };
+
+        Node *node = new Node
+        {
+            RBColor::Red,
+            key,
+            V(std::forward<A>(a)...)
+        };
+
+        set_node(node);
+
+        return { node, true };
+    }
+
+    // assigns value to the key if it is in the tree and inserts it if not, returns whether it was inserted
+    template<class M>
+    std::pair<Node*, bool> insert_or_assign(const K &key, M &&value)
+    {
+        if (Node *node = find_node(key))
+        {
+            node->value = std::forward<M>(value);
+            return { node, false };
+        }
+
+        return try_emplace(key, std::forward<M>(value));
+    }
+
+    // returns true if the key was erased
+    bool erase(const K &key)
     {
         Node *n = find_node(key);
+
+        if (!n)
+            return false;
+
         Node *y = n;
 
         RBColor color = y->color;
 
+        // x takes the place of the removed node and can be null, so its parent is tracked on the side
         Node *x = nullptr;
+        Node *x_parent = nullptr;
 
         if (!n->left)
         {
             x = n->right;
+            x_parent = n->parent;
             transplant(n, n->right);
         }
         else if (!n->right)
         {
             x = n->left;
+            x_parent = n->parent;
             transplant(n, n->left);
         }
         else
@@ -138,18 +206,18 @@ public:
 
             x = y->right;
 
-            if (x && y->parent == n)
+            if (y->parent == n)
             {
-                x->parent = y;
-            } 
+                x_parent = y;
+            }
             else
             {
+                x_parent = y->parent;
+
                 transplant(y, y->right);
 
                 y->right = n->right;
-                
-                if (y->right)
-                    y->right->parent = y;
+                y->right->parent = y;
             }
 
             transplant(n, y);
@@ -159,15 +227,31 @@ public:
             y->color = n->color;
         }
 
+        delete n;
+        m_node_count--;
+
         if (color == RBColor::Black)
         {
-            erase_fixup(x);
+            erase_fixup(x, x_parent);
         }
+
+        return true;
     }
 
 private:
     Node  *m_root = nullptr;
-    size_t m_node_count;
+    size_t m_node_count = 0;
+
+    void destroy(Node *node)
+    {
+        if (!node)
+            return;
+
+        destroy(node->left);
+        destroy(node->right);
+
+        delete node;
+    }
 
     void transplant(Node *u, Node *v)
     {
@@ -251,7 +335,7 @@ private:
     {
         Node *y = n->left;
 
-        n->right = y->left;
+        n->left = y->right;
 
         if (y->right)
         {
@@ -273,156 +357,173 @@ private:
             n->parent->right = y;
         }
 
-        y->left   = n;
+        y->right  = n;
         n->parent = y;
     }
 
     void balance(Node *n)
     {
-        Node *p = n->parent;
-
-        while (p && p->is_red())
+        while (n->parent && n->parent->is_red())
         {
-            if (p->parent->left == p)
+            // a red parent is never the root so the grandparent exists
+            Node *p = n->parent;
+            Node *g = p->parent;
+
+            if (g->left == p)
             {
-                Node *y = p->parent->right;
+                Node *y = g->right;
 
-                if (y->is_red())
+                if (y && y->is_red())
                 {
-                    p->parent->color = RBColor::Red;
+                    g->color = RBColor::Red;
 
-                    p->color         = RBColor::Black;
-                    y->color         = RBColor::Black;
+                    p->color = RBColor::Black;
+                    y->color = RBColor::Black;
 
-                    n = p->parent;
-                }
-                else if (n == p->right)
-                {
-                    n = p;
-                    rotate_left(n);
+                    n = g;
                 }
                 else
                 {
-                    p->color         = RBColor::Black;
-                    p->parent->color = RBColor::Red;
+                    if (n == p->right)
+                    {
+                        n = p;
+                        rotate_left(n);
+                        p = n->parent;
+                    }
+
+                    p->color = RBColor::Black;
+                    g->color = RBColor::Red;
 
-                    rotate_right(p->parent);
+                    rotate_right(g);
                 }
             }
             else
             {
-                if (p->parent->left && p->parent->left->is_red())
+                Node *y = g->left;
+
+                if (y && y->is_red())
                 {
-                    p->parent->color = RBColor::Red;
+                    g->color = RBColor::Red;
 
-                    p->parent->left->color  = RBColor::Black;
-                    p->parent->right->color = RBColor::Black;
+                    p->color = RBColor::Black;
+                    y->color = RBColor::Black;
 
-                    n = p->parent;
-                }
-                else if (n == p->left)
-                {
-                    n = p;
-                    rotate_right(n);
+                    n = g;
                 }
                 else
                 {
-                    p->color         = RBColor::Black;
-                    p->parent->color = RBColor::Red;
+                    if (n == p->left)
+                    {
+                        n = p;
+                        rotate_right(n);
+                        p = n->parent;
+                    }
 
-                    rotate_left(p->parent);
+                    p->color = RBColor::Black;
+                    g->color = RBColor::Red;
+
+                    rotate_left(g);
                 }
             }
-            
         }
 
         m_root->color = RBColor::Black;
     }
 
-    void erase_fixup(Node *n)
+    // null leaves count as black
+    static bool red(const Node *n)
     {
-        while (n != m_root && n->color == RBColor::Black)
+        return n && n->is_red();
+    }
+
+    // n carries an extra black and may be null, parent is its parent either way
+    void erase_fixup(Node *n, Node *parent)
+    {
+        while (n != m_root && !red(n))
         {
-            if (n == n->parent->left)
+            if (n == parent->left)
             {
-                Node *w = n->parent->right;
+                Node *w = parent->right;
 
-                if (w->is_red())
+                if (red(w))
                 {
                     w->color = RBColor::Black;
-                    n->parent->color = RBColor::Red;
+                    parent->color = RBColor::Red;
 
-                    rotate_left(n->parent);
+                    rotate_left(parent);
 
-                    w = n->parent->right;
+                    w = parent->right;
                 }
-                if (!w->is_red() && !w->right->is_red())
+                if (!red(w->left) && !red(w->right))
                 {
                     w->color = RBColor::Red;
-                    n = n->parent;
+                    n = parent;
+                    parent = n->parent;
                 }
                 else 
                 {
-                    if (!w->right->is_red())
+                    if (!red(w->right))
                     {
                         w->left->color = RBColor::Black;
                         w->color = RBColor::Red;
 
                         rotate_right(w);
 
-                        w = n->parent->right;
+                        w = parent->right;
                     }
 
-                    w->color = n->parent->color;
-                    n->parent->color = RBColor::Black;
+                    w->color = parent->color;
+                    parent->color = RBColor::Black;
                     w->right->color = RBColor::Black;
 
-                    rotate_left(n->parent);
+                    rotate_left(parent);
 
                     n = m_root;
                 }
             }
             else
             {
-                Node *w = n->parent->left;
+                Node *w = parent->left;
 
-                if (w->is_red())
+                if (red(w))
                 {
                     w->color = RBColor::Black;
-                    n->parent->color = RBColor::Red;
+                    parent->color = RBColor::Red;
 
-                    rotate_right(n->parent);
+                    rotate_right(parent);
 
-                    w = n->parent->left;
+                    w = parent->left;
                 }
-                if (!w->is_red() && !w->left->is_red())
+                if (!red(w->left) && !red(w->right))
                 {
                     w->color = RBColor::Red;
-                    n = n->parent;
+                    n = parent;
+                    parent = n->parent;
                 }
                 else 
                 {
-                    if (!w->left->is_red())
+                    if (!red(w->left))
                     {
-                        w->left->color = RBColor::Black;
+                        w->right->color = RBColor::Black;
                         w->color = RBColor::Red;
 
                         rotate_left(w);
 
-                        w = n->parent->left;
+                        w = parent->left;
                     }
 
-                    w->color = n->parent->color;
-                    n->parent->color = RBColor::Black;
+                    w->color = parent->color;
+                    parent->color = RBColor::Black;
                     w->left->color = RBColor::Black;
 
-                    rotate_right(n->parent);
+                    rotate_right(parent);
 
                     n = m_root;
                 }
             }
         }
 
-        n->color = RBColor::Black;
+        if (n)
+            n->color = RBColor::Black;
     }
 };
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <tuple>
 #include <utility>
+#include <type_traits>
 
 template<typename K, typename V>
 struct Record
@@ -18,12 +20,21 @@ struct Record
             value(value)
     {}
 
-    Record(Record &&item) noexcept :
+    // key and value are constructed in place from their own arguments, like std::pair
+    //
+    //     Record<std::string, Buffer> r(std::piecewise_construct, std::forward_as_tuple("name"), std::forward_as_tuple(4096));
+    template<class ...KA, class ...VA>
+    Record(std::piecewise_construct_t, std::tuple<KA...> key_args, std::tuple<VA...> value_args) :
+            key(std::make_from_tuple<K>(std::move(key_args))),
+            value(std::make_from_tuple<V>(std::move(value_args)))
+    {}
+
+    Record(Record &&item) noexcept(std::is_nothrow_move_constructible_v<K> && std::is_nothrow_move_constructible_v<V>) :
             key(std::move(item.key)),
             value(std::move(item.value))
     {}
 
-    Record(const Record &item) noexcept :
+    Record(const Record &item) :
             key(item.key),
             value(item.value)
     {}
@@ -35,7 +46,7 @@ struct Record
         return *this;
     }
 
-    Record& operator=(Record &&item) noexcept
+    Record& operator=(Record &&item) noexcept(std::is_nothrow_move_assignable_v<K> && std::is_nothrow_move_assignable_v<V>)
     {
         key = std::move(item.key);
         value = std::move(item.value);
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "util.hpp"
+
+// read only lower_bound over sorted keys in eytzinger order, the implicit binary tree stored breadth first
+// the first levels of the tree share a handful of cache lines so they stay hot, and since the 16 great grandchildren
+// of a node (for 4 byte keys) sit on one line the search can prefetch four levels ahead while it is still comparing,
+// the descent has no branch on the comparison so there is nothing to mispredict
+template<class T>
+class StaticSearchIndex
+{
+public:
+
+    StaticSearchIndex() = default;
+
+    template<is_container C>
+    explicit StaticSearchIndex(const C& sorted)
+    {
+        rebuild(sorted);
+    }
+
+    StaticSearchIndex(const StaticSearchIndex&) = delete;
+    StaticSearchIndex& operator=(const StaticSearchIndex&) = delete;
+
+    StaticSearchIndex(StaticSearchIndex&&) noexcept = default;
+    StaticSearchIndex& operator=(StaticSearchIndex&&) noexcept = default;
+
+    // lays the keys out again in O(n), the container has to be sorted
+    template<is_container C>
+    void rebuild(const C& sorted)
+    {
+        m_size = sorted.size();
+
+        if(m_size >= UINT32_MAX)
+            throw std::out_of_range("Too many keys for the index");
+
+        // slot 0 is unused so the children of k are 2k and 2k+1, the block is aligned so that every
+        // group of great grandchildren starts on a cache line
+        m_keys  = Buffer<T>(m_size + 1);
+        m_ranks = Buffer<uint32_t>(m_size + 1);
+
+        size_t rank = 0;
+        auto   it   = sorted.begin();
+
+        // in order walk of the implicit tree without recursion, left as deep as possible then up and right
+        size_t k = 1;
+
+        while(rank < m_size)
+        {
+            while(k <= m_size)
+                k <<= 1;
+
+            // back up out of the empty left subtree to the next node in order
+            k >>= std::countr_one(k) + 1;
+
+            m_keys[k]  = *it;
+            m_ranks[k] = uint32_t(rank);
+
+            ++it;
+            ++rank;
+
+            k = 2 * k + 1;
+        }
+    }
+
+    // position in the sorted source of the first key not below key, size() if there is none
+    size_t lower_bound(const T& key) const
+    {
+        size_t k = search(key);
+        return k ? m_ranks[k] : m_size;
+    }
+
+    [[nodiscard]]
+    bool contains(const T& key) const
+    {
+        size_t k = search(key);
+        return k && !(key < m_keys[k]);
+    }
+
+    // returns npos if the key is not there
+    size_t index_of(const T& key) const
+    {
+        size_t k = search(key);
+        return k && !(key < m_keys[k]) ? m_ranks[k] : npos;
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    bool empty() const { return m_size == 0; }
+
+private:
+
+    static constexpr size_t huge_page = 2 * 1024 * 1024;
+
+    // cache line aligned array, big ones are aligned to huge pages and asked to be backed by them
+    // since past a few megabytes every level of the search is a TLB miss as well as a cache miss
+    template<class U>
+    struct Buffer
+    {
+        struct Free
+        {
+            size_t alignment;
+
+            void operator()(U *p) const { ::operator delete(p, std::align_val_t(alignment)); }
+        };
+
+        std::unique_ptr<U, Free> data;
+
+        Buffer() : data(nullptr, Free{cache_line}) {}
+
+        explicit Buffer(size_t count) : data(nullptr, Free{cache_line})
+        {
+            size_t bytes = sizeof(U) * (count ? count : 1);
+
+            if(bytes >= huge_page)
+            {
+                bytes = (bytes + huge_page - 1) & ~(huge_page - 1);
+                data  = std::unique_ptr<U, Free>(static_cast<U*>(::operator new(bytes, std::align_val_t(huge_page))), Free{huge_page});
+#ifdef MADV_HUGEPAGE
+                madvise(data.get(), bytes, MADV_HUGEPAGE);
+#endif
+                return;
+            }
+
+            data = std::unique_ptr<U, Free>(static_cast<U*>(::operator new(bytes, std::align_val_t(cache_line))), Free{cache_line});
+        }
+
+        inline U& operator[](size_t index) const { return data.get()[index]; }
+        inline U* get() const { return data.get(); }
+    };
+
+    static_assert(std::is_trivially_copyable_v<T>, "the keys are copied into raw storage");
+
+    // the descendants of k four levels down start at k * 16, that is a whole line for 4 byte keys
+    static constexpr size_t lookahead = cache_line / sizeof(T) > 1 ? cache_line / sizeof(T) : 2;
+
+    Buffer<T>        m_keys;
+    Buffer<uint32_t> m_ranks;
+    size_t           m_size = 0;
+
+    // the eytzinger index of the lower bound, 0 if every key is below key
+    inline size_t search(const T& key) const
+    {
+        const T *keys = m_keys.get();
+        size_t   k    = 1;
+
+        while(k <= m_size)
+        {
+            // the address is only a hint, past the end it is never read
+            __builtin_prefetch(reinterpret_cast<const char*>(keys) + (k * lookahead) * sizeof(T));
+
+            k = 2 * k + (keys[k] < key);
+        }
+
+        // the path went right every time a key was below, the lower bound is where it last went left
+        k >>= std::countr_one(k) + 1;
+
+        return k;
+    }
+};
+
+// lower_bound on a StaticSearchIndex against std::lower_bound over the sorted keys, random queries
+void search_index_bench(const size_t keys, const size_t queries = 1 << 22)
+{
+    using namespace std::chrono;
+
+    std::mt19937 rng(7);
+
+    std::vector<uint32_t> sorted(keys);
+
+    for(auto &key : sorted)
+        key = rng();
+
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<uint32_t> targets(queries);
+
+    for(auto &target : targets)
+        target = rng();
+
+    auto start = steady_clock::now();
+    StaticSearchIndex<uint32_t> index(sorted);
+    auto build = duration_cast<milliseconds>(steady_clock::now() - start);
+
+    size_t check = 0;
+
+    start = steady_clock::now();
+    for(uint32_t target : targets)
+        check += std::lower_bound(sorted.begin(), sorted.end(), target) - sorted.begin();
+    auto binary = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for(uint32_t target : targets)
+        check -= index.lower_bound(target);
+    auto eytzinger = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    std::cout
+            << keys << " keys, " << queries << " lower_bound queries" << (check ? " MISMATCH" : "") << '\n'
+            << "  std::lower_bound:  " << binary * 1e9 / double(queries) << " ns/query\n"
+            << "  StaticSearchIndex: " << eytzinger * 1e9 / double(queries) << " ns/query, built in " << build << '\n';
+}
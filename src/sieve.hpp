@@ -0,0 +1,311 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <bit>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// segmented sieve of eratosthenes over a mod 30 wheel
+// every byte covers 30 numbers with one bit per residue coprime to 30 so only 8/30 of the range is stored,
+// segments are sized to fit in L1 and a batch of them is sieved in parallel on the shared ThreadPool,
+// the workers and their segment buffers live across batches so streaming a large range starts no threads
+
+class SegmentedSieve
+{
+public:
+
+    static constexpr size_t segment_bytes = 32 * 1024;
+
+    SegmentedSieve(size_t start, size_t end, size_t threads = 0) : m_start(start), m_end(end)
+    {
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+
+        m_threads = threads ? threads : 1;
+
+        if(m_end <= m_start)
+            m_end = m_start;
+
+        m_first_byte = m_start / 30;
+        m_last_byte  = (m_end + 29) / 30;
+        m_segments   = (m_last_byte - m_first_byte + segment_bytes - 1) / segment_bytes;
+
+        size_t limit = std::sqrt(double(m_end));
+
+        while(limit * limit > m_end)
+            limit--;
+        while((limit + 1) * (limit + 1) <= m_end)
+            limit++;
+
+        m_base = base_primes(limit);
+    }
+
+    // appends the primes of the next batch of segments in order, returns false once the range is exhausted
+    bool next_batch(std::vector<size_t> &output)
+    {
+        if(m_next == 0 && !m_small_done)
+        {
+            m_small_done = true;
+
+            for(size_t p : {2, 3, 5})
+            {
+                if(p >= m_start && p < m_end)
+                    output.push_back(p);
+            }
+        }
+
+        if(m_next >= m_segments)
+            return false;
+
+        size_t batch = std::min(m_threads, m_segments - m_next);
+
+        m_found.resize(batch);
+
+        parallel(batch, [&](size_t t, uint8_t *bits)
+        {
+            m_found[t].clear();
+
+            size_t bytes = sieve(m_next + t, bits);
+            extract(m_next + t, bits, bytes, m_found[t]);
+        });
+
+        for(size_t t = 0; t < batch; t++)
+            output.insert(output.end(), m_found[t].begin(), m_found[t].end());
+
+        m_next += batch;
+
+        return true;
+    }
+
+    // calls fn with every prime in the range in ascending order
+    template<typename FN>
+    void for_each(FN fn)
+    {
+        std::vector<size_t> batch;
+
+        rewind();
+
+        while(next_batch(batch) || !batch.empty())
+        {
+            for(size_t p : batch)
+                fn(p);
+
+            batch.clear();
+        }
+    }
+
+    // counts the primes in the range, segments are spread over the threads and never leave L1
+    size_t count() const
+    {
+        size_t total = 0;
+
+        for(size_t p : {2, 3, 5})
+        {
+            if(p >= m_start && p < m_end)
+                total++;
+        }
+
+        std::vector<size_t> counts(m_threads);
+
+        parallel(m_threads, [&](size_t t, uint8_t *bits)
+        {
+            for(size_t segment = t; segment < m_segments; segment += m_threads)
+            {
+                size_t bytes = sieve(segment, bits);
+                counts[t] += popcount(bits, bytes);
+            }
+        });
+
+        for(size_t c : counts)
+            total += c;
+
+        return total;
+    }
+
+    void rewind()
+    {
+        m_next       = 0;
+        m_small_done = false;
+    }
+
+    // primes from 7 up to and including limit, the sieving primes for a range that ends at (limit+1)^2
+    static std::vector<size_t> base_primes(size_t limit)
+    {
+        std::vector<size_t> output;
+
+        if(limit < 1024)
+        {
+            for(size_t n = 7; n <= limit; n += 2)
+            {
+                bool prime = true;
+
+                for(size_t d = 3; d * d <= n && prime; d += 2)
+                    prime = n % d != 0;
+
+                if(prime)
+                    output.push_back(n);
+            }
+
+            return output;
+        }
+
+        SegmentedSieve sieve(7, limit + 1, 1);
+
+        sieve.for_each([&](size_t p) { output.push_back(p); });
+
+        return output;
+    }
+
+    [[nodiscard]]
+    size_t start() const { return m_start; }
+
+    [[nodiscard]]
+    size_t end() const { return m_end; }
+
+    [[nodiscard]]
+    size_t threads() const { return m_threads; }
+
+private:
+    static constexpr uint8_t wheel[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+    static constexpr uint8_t gaps[8]  = { 6, 4, 2, 4, 2, 4, 6, 2 };
+
+    // bit of each residue mod 30, only residues on the wheel are ever looked up
+    static constexpr uint8_t bit_of[30] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 1, 0, 0,
+        0, 2, 0, 3, 0, 0, 0, 4, 0, 5,
+        0, 0, 0, 6, 0, 0, 0, 0, 0, 7,
+    };
+
+    // index of the first wheel residue at or above each residue
+    static constexpr uint8_t next_spoke[30] =
+    {
+        0, 0, 1, 1, 1, 1, 1, 1, 2, 2,
+        2, 2, 3, 3, 4, 4, 4, 4, 5, 5,
+        6, 6, 6, 6, 7, 7, 7, 7, 7, 7,
+    };
+
+    size_t m_start;
+    size_t m_end;
+    size_t m_threads;
+
+    size_t m_first_byte;
+    size_t m_last_byte;
+    size_t m_segments;
+
+    size_t m_next       = 0;
+    bool   m_small_done = false;
+
+    std::vector<size_t> m_base;
+
+    // the primes of each segment of a batch, kept so their capacity carries over to the next batch
+    std::vector<std::vector<size_t>> m_found;
+
+    // runs fn(t, buffer) for every t in [0, batch) on the pool's workers, the calling thread joins in
+    template<typename FN>
+    void parallel(size_t batch, FN fn) const
+    {
+        if(batch == 1)
+        {
+            fn(0, buffer());
+            return;
+        }
+
+        ThreadPool::global().run_chunks(batch, [&](size_t first, size_t last)
+        {
+            for(size_t t = first; t < last; t++)
+                fn(t, buffer());
+        });
+    }
+
+    // one segment buffer per thread, allocated the first time that thread sieves
+    static uint8_t* buffer()
+    {
+        thread_local std::vector<uint8_t> bits(segment_bytes);
+        return bits.data();
+    }
+
+    // sieves one segment into bits and returns how many bytes of it are in the range
+    size_t sieve(size_t segment, uint8_t *bits) const
+    {
+        size_t first = m_first_byte + segment * segment_bytes;
+        size_t bytes = std::min(segment_bytes, m_last_byte - first);
+
+        size_t low  = first * 30;
+        size_t high = (first + bytes) * 30;
+
+        std::memset(bits, 0xff, bytes);
+
+        for(size_t p : m_base)
+        {
+            if(p * p >= high)
+                break;
+
+            // the first multiple worth crossing is p*q with q >= p, p*q >= low and q on the wheel
+            size_t q = std::max(p, (low + p - 1) / p);
+            size_t r = q % 30;
+            size_t i = next_spoke[r];
+
+            q += wheel[i] - r;
+
+            for(size_t m = p * q; m < high; m += p * gaps[i], i = (i + 1) & 7)
+            {
+                size_t offset = m - low;
+                bits[offset / 30] &= uint8_t(~(1u << bit_of[offset % 30]));
+            }
+        }
+
+        // 1 is not prime and numbers outside [start, end) do not belong to the range
+        if(first == 0)
+            bits[0] &= 0xfe;
+
+        for(size_t i = 0; i < 8 && low < m_start; i++)
+        {
+            if(low + wheel[i] < m_start)
+                bits[0] &= uint8_t(~(1u << i));
+        }
+
+        for(size_t i = 0; i < 8; i++)
+        {
+            if(high - 30 + wheel[i] >= m_end)
+                bits[bytes - 1] &= uint8_t(~(1u << i));
+        }
+
+        return bytes;
+    }
+
+    void extract(size_t segment, const uint8_t *bits, size_t bytes, std::vector<size_t> &output) const
+    {
+        size_t first = m_first_byte + segment * segment_bytes;
+
+        for(size_t byte = 0; byte < bytes; byte++)
+        {
+            for(uint8_t b = bits[byte]; b; b &= b - 1)
+                output.push_back((first + byte) * 30 + wheel[std::countr_zero(b)]);
+        }
+    }
+
+    static size_t popcount(const uint8_t *bits, size_t bytes)
+    {
+        size_t total = 0;
+        size_t i     = 0;
+
+        for(; i + 8 <= bytes; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bits + i, 8);
+            total += std::popcount(word);
+        }
+
+        for(; i < bytes; i++)
+            total += std::popcount(bits[i]);
+
+        return total;
+    }
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+
+// vectorized kernels over arrays of arithmetic values, what the container:: algorithms use for contiguous containers
+// every kernel is written once over gcc vector types in simd_kernels.hpp and compiled for 64 byte AVX-512, 32 byte AVX2
+// and the 16 byte baseline, which one runs is picked at runtime from what the cpu supports
+// several accumulators run side by side so consecutive adds and compares do not wait on each other
+
+namespace simd
+{
+    // types the kernels take, long double and bool have no vector form
+    template<typename T>
+    concept is_vectorizable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 8;
+
+    enum class Level : uint8_t
+    {
+        Base, AVX2, AVX512
+    };
+
+    inline Level detect()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")
+           && __builtin_cpu_supports("popcnt"))
+            return Level::AVX512;
+
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+            return Level::AVX2;
+#endif
+        return Level::Base;
+    }
+
+    // checked once per process
+    inline Level level()
+    {
+        static const Level current = detect();
+        return current;
+    }
+
+    // what bitwise combines two arrays of words with, AndNot keeps the bits of the first that are not in the second
+    enum class BitOp : uint8_t
+    {
+        And, Or, Xor, AndNot
+    };
+
+    namespace kernel
+    {
+        template<typename T, size_t Bytes>
+        struct pack_of
+        {
+            typedef T type __attribute__((vector_size(Bytes)));
+        };
+
+        template<typename T, size_t Bytes>
+        using pack = typename pack_of<T, Bytes>::type;
+
+        // integers are added as unsigned so lanes that overflow wrap instead of being undefined
+        template<typename T>
+        using accumulator = typename std::conditional_t<std::is_integral_v<T>, std::make_unsigned<T>, std::type_identity<T>>::type;
+    }
+
+    // the same kernels once per instruction set, a function compiled for one set cannot inline code compiled
+    // for another so each copy has to be compiled whole under its own target
+
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512dq,popcnt")
+    namespace avx512
+    {
+        static constexpr size_t bytes = 64;
+
+#include "simd_kernels.hpp"
+    }
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+    namespace avx2
+    {
+        static constexpr size_t bytes = 32;
+
+#include "simd_kernels.hpp"
+    }
+#pragma GCC pop_options
+#endif
+
+    namespace base
+    {
+        static constexpr size_t bytes = 16;
+
+#include "simd_kernels.hpp"
+    }
+
+    // plain loops with the same results, run in constant expressions where vector types cannot be used
+    namespace scalar
+    {
+        template<typename T>
+        constexpr T sum(const T *data, size_t count)
+        {
+            using U = kernel::accumulator<T>;
+
+            U total = U();
+
+            for(size_t i = 0; i < count; i++)
+                total += U(data[i]);
+
+            return T(total);
+        }
+
+        template<typename T>
+        constexpr std::pair<T, T> minmax(const T *data, size_t count)
+        {
+            T low = data[0], high = data[0];
+
+            for(size_t i = 1; i < count; i++)
+            {
+                if(data[i] < low)
+                    low = data[i];
+
+                if(high < data[i])
+                    high = data[i];
+            }
+
+            return { low, high };
+        }
+
+        template<typename T>
+        constexpr size_t index_of(const T *data, size_t count, T item)
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                if(data[i] == item)
+                    return i;
+            }
+
+            return npos;
+        }
+
+        template<typename T>
+        constexpr size_t count(const T *data, size_t count, T item)
+        {
+            size_t found = 0;
+
+            for(size_t i = 0; i < count; i++)
+                found += data[i] == item;
+
+            return found;
+        }
+    }
+
+    template<is_vectorizable T>
+    constexpr T sum(const T *data, size_t count)
+    {
+        if(std::is_constant_evaluated())
+            return scalar::sum(data, count);
+
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::sum(data, count);
+            case Level::AVX2:   return avx2::sum(data, count);
+            default:            break;
+        }
+#endif
+        return base::sum(data, count);
+    }
+
+    // count has to be at least 1
+    template<is_vectorizable T>
+    constexpr std::pair<T, T> minmax(const T *data, size_t count)
+    {
+        if(std::is_constant_evaluated())
+            return scalar::minmax(data, count);
+
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::minmax(data, count);
+            case Level::AVX2:   return avx2::minmax(data, count);
+            default:            break;
+        }
+#endif
+        return base::minmax(data, count);
+    }
+
+    template<is_vectorizable T>
+    constexpr T min(const T *data, size_t count)
+    {
+        return minmax(data, count).first;
+    }
+
+    template<is_vectorizable T>
+    constexpr T max(const T *data, size_t count)
+    {
+        return minmax(data, count).second;
+    }
+
+    // npos if item is not there
+    template<is_vectorizable T>
+    constexpr size_t index_of(const T *data, size_t count, T item)
+    {
+        if(std::is_constant_evaluated())
+            return scalar::index_of(data, count, item);
+
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::index_of(data, count, item);
+            case Level::AVX2:   return avx2::index_of(data, count, item);
+            default:            break;
+        }
+#endif
+        return base::index_of(data, count, item);
+    }
+
+    template<is_vectorizable T>
+    constexpr size_t count(const T *data, size_t count, T item)
+    {
+        if(std::is_constant_evaluated())
+            return scalar::count(data, count, item);
+
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::count(data, count, item);
+            case Level::AVX2:   return avx2::count(data, count, item);
+            default:            break;
+        }
+#endif
+        return base::count(data, count, item);
+    }
+
+    // out = out op in for count words
+    template<BitOp Op>
+    void bitwise(uint64_t *out, const uint64_t *in, size_t count)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::bitwise<Op>(out, in, count);
+            case Level::AVX2:   return avx2::bitwise<Op>(out, in, count);
+            default:            break;
+        }
+#endif
+        return base::bitwise<Op>(out, in, count);
+    }
+
+    // number of set bits in count words
+    inline size_t popcount(const uint64_t *words, size_t count)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        switch(level())
+        {
+            case Level::AVX512: return avx512::popcount(words, count);
+            case Level::AVX2:   return avx2::popcount(words, count);
+            default:            break;
+        }
+#endif
+        return base::popcount(words, count);
+    }
+}
+
+// the kernels against the plain loops they replace, on int and float
+void simd_bench(const size_t items = 1 << 24)
+{
+    using namespace std::chrono;
+
+    static const char *levels[] = { "baseline", "AVX2", "AVX-512" };
+
+    auto time = [](auto fn)
+    {
+        auto start = steady_clock::now();
+
+        volatile auto result = fn();
+        (void)result;
+
+        return duration_cast<duration<double>>(steady_clock::now() - start).count() * 1e3;
+    };
+
+    auto run = [&]<typename T>(const char *name, const std::vector<T> &values)
+    {
+        const T *data = values.data();
+        const T  key  = T(-1);
+
+        double loop_sum = time([&] { T total = T(); for(size_t i = 0; i < items; i++) total += data[i]; return total; });
+        double simd_sum = time([&] { return simd::sum(data, items); });
+
+        double loop_minmax = time([&]
+        {
+            T low = data[0], high = data[0];
+
+            for(size_t i = 0; i < items; i++)
+            {
+                if(data[i] < low)
+                    low = data[i];
+
+                if(high < data[i])
+                    high = data[i];
+            }
+
+            return low + high;
+        });
+        double simd_minmax = time([&] { auto [low, high] = simd::minmax(data, items); return low + high; });
+
+        double loop_index = time([&] { for(size_t i = 0; i < items; i++) if(data[i] == key) return i; return npos; });
+        double simd_index = time([&] { return simd::index_of(data, items, key); });
+
+        double loop_count = time([&] { size_t found = 0; for(size_t i = 0; i < items; i++) found += data[i] == key; return found; });
+        double simd_count = time([&] { return simd::count(data, items, key); });
+
+        std::cout
+                << "  " << name << " ms, loop / simd"
+                << "  sum: " << loop_sum << " / " << simd_sum
+                << "  minmax: " << loop_minmax << " / " << simd_minmax
+                << "  index_of: " << loop_index << " / " << simd_index
+                << "  count: " << loop_count << " / " << simd_count << '\n';
+    };
+
+    std::vector<int>   ints(items);
+    std::vector<float> floats(items);
+
+    for(size_t i = 0; i < items; i++)
+    {
+        ints[i]   = int(i % 1000);
+        floats[i] = float(i % 1000);
+    }
+
+    std::cout << items << " items, " << levels[size_t(simd::level())] << " kernels\n";
+
+    run("int  ", ints);
+    run("float", floats);
+}
@@ -0,0 +1,223 @@
+// no include guard, simd.hpp includes this once per instruction set inside a namespace that sets bytes,
+// the vector width, with the matching #pragma GCC target active so every kernel is compiled for that set
+
+template<typename V, typename T>
+inline V load(const T *data)
+{
+    V value;
+    __builtin_memcpy(&value, data, sizeof(V));
+    return value;
+}
+
+template<typename V, typename T>
+inline void store(T *data, V value)
+{
+    __builtin_memcpy(data, &value, sizeof(V));
+}
+
+template<typename V, typename T>
+inline V splat(T value)
+{
+    V out;
+
+    for(size_t i = 0; i < sizeof(V) / sizeof(T); i++)
+        out[i] = value;
+
+    return out;
+}
+
+template<typename T>
+T sum(const T *data, size_t count)
+{
+    using U = kernel::accumulator<T>;
+    using V = kernel::pack<U, bytes>;
+    constexpr size_t W = bytes / sizeof(T);
+
+    V a{}, b{}, c{}, d{};
+    size_t i = 0;
+
+    for(; i + 4 * W <= count; i += 4 * W)
+    {
+        a += load<V>(data + i);
+        b += load<V>(data + i + W);
+        c += load<V>(data + i + 2 * W);
+        d += load<V>(data + i + 3 * W);
+    }
+
+    for(; i + W <= count; i += W)
+        a += load<V>(data + i);
+
+    a = (a + b) + (c + d);
+
+    U total = U();
+
+    for(size_t j = 0; j < W; j++)
+        total += a[j];
+
+    for(; i < count; i++)
+        total += U(data[i]);
+
+    return T(total);
+}
+
+// count has to be at least 1
+template<typename T>
+std::pair<T, T> minmax(const T *data, size_t count)
+{
+    using V = kernel::pack<T, bytes>;
+    constexpr size_t W = bytes / sizeof(T);
+
+    V low_a = splat<V>(data[0]), low_b = low_a;
+    V high_a = low_a, high_b = low_a;
+    size_t i = 0;
+
+    for(; i + 2 * W <= count; i += 2 * W)
+    {
+        V x = load<V>(data + i);
+        V y = load<V>(data + i + W);
+
+        low_a  = x < low_a  ? x : low_a;
+        low_b  = y < low_b  ? y : low_b;
+        high_a = high_a < x ? x : high_a;
+        high_b = high_b < y ? y : high_b;
+    }
+
+    low_a  = low_b < low_a ? low_b : low_a;
+    high_a = high_a < high_b ? high_b : high_a;
+
+    T low = data[0], high = data[0];
+
+    for(size_t j = 0; j < W; j++)
+    {
+        if(low_a[j] < low)
+            low = low_a[j];
+
+        if(high < high_a[j])
+            high = high_a[j];
+    }
+
+    for(; i < count; i++)
+    {
+        if(data[i] < low)
+            low = data[i];
+
+        if(high < data[i])
+            high = data[i];
+    }
+
+    return { low, high };
+}
+
+// like memchr, four vectors are compared before a single branch and the hit is then found one by one
+template<typename T>
+size_t index_of(const T *data, size_t count, T item)
+{
+    using V     = kernel::pack<T, bytes>;
+    using Words = kernel::pack<uint64_t, bytes>;
+    constexpr size_t W = bytes / sizeof(T);
+
+    V key = splat<V>(item);
+    size_t i = 0;
+
+    for(; i + 4 * W <= count; i += 4 * W)
+    {
+        auto hit = (load<V>(data + i) == key) | (load<V>(data + i + W) == key)
+                 | (load<V>(data + i + 2 * W) == key) | (load<V>(data + i + 3 * W) == key);
+
+        Words words = (Words)hit;
+        uint64_t any = 0;
+
+        for(size_t j = 0; j < bytes / 8; j++)
+            any |= words[j];
+
+        if(any)
+            break;
+    }
+
+    for(; i < count; i++)
+    {
+        if(data[i] == item)
+            return i;
+    }
+
+    return npos;
+}
+
+template<typename T>
+size_t count(const T *data, size_t count, T item)
+{
+    using V    = kernel::pack<T, bytes>;
+    using M    = decltype(V() == V());
+    using Lane = std::remove_cvref_t<decltype(M()[0])>;
+    constexpr size_t W = bytes / sizeof(T);
+
+    // a compare is -1 where it matched, the lanes are narrow so they are emptied before they can overflow
+    constexpr size_t limit = sizeof(Lane) >= 4 ? size_t(1) << 30 : (size_t(1) << (sizeof(Lane) * 8 - 1)) - 1;
+
+    V key = splat<V>(item);
+    size_t found = 0;
+    size_t i = 0;
+
+    while(i + W <= count)
+    {
+        M matches{};
+
+        for(size_t steps = 0; steps < limit && i + W <= count; steps++, i += W)
+            matches -= (load<V>(data + i) == key);
+
+        for(size_t j = 0; j < W; j++)
+            found += size_t(matches[j]);
+    }
+
+    for(; i < count; i++)
+        found += data[i] == item;
+
+    return found;
+}
+
+// out = out op in over whole words, the compiler turns each case into the single vector instruction
+template<BitOp Op>
+void bitwise(uint64_t *out, const uint64_t *in, size_t words)
+{
+    using V = kernel::pack<uint64_t, bytes>;
+    constexpr size_t W = bytes / 8;
+
+    auto apply = [](auto a, auto b)
+    {
+        if constexpr(Op == BitOp::And)         return a & b;
+        else if constexpr(Op == BitOp::Or)     return a | b;
+        else if constexpr(Op == BitOp::Xor)    return a ^ b;
+        else                                   return a & ~b;
+    };
+
+    size_t i = 0;
+
+    for(; i + 2 * W <= words; i += 2 * W)
+    {
+        store(out + i,     apply(load<V>(out + i),     load<V>(in + i)));
+        store(out + i + W, apply(load<V>(out + i + W), load<V>(in + i + W)));
+    }
+
+    for(; i < words; i++)
+        out[i] = apply(out[i], in[i]);
+}
+
+// set bits in the words, four counts run side by side so the popcnt instructions overlap
+inline size_t popcount(const uint64_t *words, size_t count)
+{
+    size_t a = 0, b = 0, c = 0, d = 0;
+    const uint64_t *last = words + count;
+
+    for(; last - words >= 4; words += 4)
+    {
+        a += size_t(__builtin_popcountll(words[0]));
+        b += size_t(__builtin_popcountll(words[1]));
+        c += size_t(__builtin_popcountll(words[2]));
+        d += size_t(__builtin_popcountll(words[3]));
+    }
+
+    for(; words != last; words++)
+        a += size_t(__builtin_popcountll(*words));
+
+    return a + b + c + d;
+}
@@ -0,0 +1,568 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "rbt.hpp"
+
+// bump allocator for nodes that live as long as their container, grabbing memory is a fetch_add on the current block
+// and only swapping in a new block takes the lock, nothing is freed until the arena goes away
+class Arena
+{
+public:
+
+    static constexpr size_t block_size = 64 * 1024;
+
+    Arena() = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        for(Block *block : m_blocks)
+            ::operator delete(block, std::align_val_t(cache_line));
+    }
+
+    // aligned to alignof(std::max_align_t), safe to call from any number of threads
+    void* allocate(size_t bytes)
+    {
+        bytes = (bytes + alignment - 1) & ~(alignment - 1);
+
+        // anything bigger than a quarter block gets a block of its own so the current one isn't wasted
+        if(bytes > block_size / 4)
+        {
+            std::lock_guard lock(m_mutex);
+            return new_block(bytes)->data();
+        }
+
+        while(true)
+        {
+            Block *block  = m_current.load(std::memory_order_acquire);
+
+            if(block)
+            {
+                size_t offset = block->used.fetch_add(bytes, std::memory_order_relaxed);
+
+                if(offset + bytes <= block->size)
+                    return block->data() + offset;
+            }
+
+            std::lock_guard lock(m_mutex);
+
+            if(m_current.load(std::memory_order_relaxed) == block)
+                m_current.store(new_block(block_size), std::memory_order_release);
+        }
+    }
+
+    // bytes taken from the system
+    [[nodiscard]]
+    size_t memory() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_memory;
+    }
+
+private:
+    static constexpr size_t alignment = alignof(std::max_align_t);
+
+    struct alignas(cache_line) Block
+    {
+        std::atomic<size_t> used{0};
+        size_t              size;
+
+        inline char* data() { return reinterpret_cast<char*>(this) + sizeof(Block); }
+    };
+
+    std::atomic<Block*> m_current{nullptr};
+    std::vector<Block*> m_blocks;
+    size_t              m_memory = 0;
+    mutable std::mutex  m_mutex;
+
+    Block* new_block(size_t size)
+    {
+        void  *memory = ::operator new(sizeof(Block) + size, std::align_val_t(cache_line));
+        Block *block  = new (memory) Block();
+
+        block->size = size;
+
+        m_blocks.push_back(block);
+        m_memory += sizeof(Block) + size;
+
+        return block;
+    }
+};
+
+// ordered map on a skip list in the style of leveldb's memtable
+// readers never lock or wait, writers link a node bottom up with one CAS per level so any number can insert at once,
+// nodes sit in an arena with their tower of links inline and are never unlinked so a reader can't land on freed memory
+// insert on a key that is already there adds a newer version in front of the old one instead of overwriting it in place,
+// erase marks the newest version dead, the old versions stay until the map is destroyed
+template<class K, class V>
+class SkipList
+{
+public:
+
+    static constexpr int max_height = 12;
+
+    struct Node
+    {
+        K key;
+        V value;
+
+        [[nodiscard]]
+        bool live() const { return m_live.load(std::memory_order_acquire); }
+
+    private:
+        friend class SkipList;
+
+        Node(const K &key, const V &value, int height) : key(key), value(value), m_height(uint8_t(height)) {}
+
+        std::atomic<bool>  m_live{true};
+        uint8_t            m_height;
+        // the tower runs past the end of the node, it is allocated with room for m_height links
+        std::atomic<Node*> m_next[1];
+    };
+
+    class Iterator;
+
+    SkipList()
+    {
+        for(auto &link : m_head)
+            link.store(nullptr, std::memory_order_relaxed);
+    }
+
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
+    // only safe once every other thread is done with the map
+    ~SkipList()
+    {
+        Node *node = m_head[0].load(std::memory_order_relaxed);
+
+        while(node)
+        {
+            Node *next = node->m_next[0].load(std::memory_order_relaxed);
+            node->~Node();
+            node = next;
+        }
+    }
+
+    // returns false if the key was already present, the new value shadows the old one either way
+    bool insert(const K &key, const V &value)
+    {
+        const int height = random_height();
+
+        void *memory = m_arena.allocate(sizeof(Node) + sizeof(std::atomic<Node*>) * (height - 1));
+        Node *node   = new (memory) Node(key, value, height);
+
+        for(int level = 1; level < height; level++)
+            new (&node->m_next[level]) std::atomic<Node*>(nullptr);
+
+        int current = m_height.load(std::memory_order_relaxed);
+
+        while(current < height && !m_height.compare_exchange_weak(current, height, std::memory_order_relaxed));
+
+        Node *preds[max_height];
+        Node *succs[max_height];
+
+        find_preds(key, preds, succs);
+
+        Node *old     = succs[0];
+        bool  present = old && !(key < old->key) && old->live();
+
+        // level 0 decides when the node is in the map, the upper levels are only shortcuts
+        for(int level = 0; level < height; level++)
+        {
+            while(true)
+            {
+                node->m_next[level].store(succs[level], std::memory_order_relaxed);
+
+                if(link(preds[level], level).compare_exchange_strong(succs[level], node, std::memory_order_release, std::memory_order_relaxed))
+                    break;
+
+                // someone linked in between, walk on from the same predecessor
+                seek(key, level, preds[level], succs[level]);
+
+                if(level == 0)
+                {
+                    old     = succs[0];
+                    present = old && !(key < old->key) && old->live();
+                }
+            }
+        }
+
+        if(!present)
+            m_size.fetch_add(1, std::memory_order_relaxed);
+
+        return !present;
+    }
+
+    // marks the key as erased, returns false if it was not there
+    bool erase(const K &key)
+    {
+        Node *node = newest(key);
+
+        if(!node)
+            return false;
+
+        bool expected = true;
+
+        if(!node->m_live.compare_exchange_strong(expected, false, std::memory_order_acq_rel))
+            return false;
+
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // the newest live version of the key or nullptr
+    Node* find_node(const K &key) const
+    {
+        Node *node = newest(key);
+        return node && node->live() ? node : nullptr;
+    }
+
+    bool contains(const K &key) const
+    {
+        return find_node(key);
+    }
+
+    V& find(const K &key) const
+    {
+        Node *node = find_node(key);
+
+        if(!node)
+            throw std::out_of_range("node does not exist in list");
+
+        return node->value;
+    }
+
+    Node* min_node() const
+    {
+        Iterator it = begin();
+        return it == end() ? nullptr : &*it;
+    }
+
+    // walks the top levels to the last key and steps back past erased keys
+    Node* max_node() const
+    {
+        Node *last = last_before(nullptr);
+
+        while(last)
+        {
+            Node *node = newest(last->key);
+
+            if(node->live())
+                return node;
+
+            last = last_before(&last->key);
+        }
+
+        return nullptr;
+    }
+
+    inline V& min() const
+    {
+        Node *node = min_node();
+
+        if(!node)
+            throw std::out_of_range("list is empty");
+
+        return node->value;
+    }
+
+    inline V& max() const
+    {
+        Node *node = max_node();
+
+        if(!node)
+            throw std::out_of_range("list is empty");
+
+        return node->value;
+    }
+
+    // the first live key at or after key
+    Iterator lower_bound(const K &key) const
+    {
+        Node *preds[max_height];
+        Node *succs[max_height];
+
+        find_preds(key, preds, succs);
+
+        return Iterator(succs[0]);
+    }
+
+    // calls fn(key, value) for every live key in [first, last)
+    template<typename FN>
+    void for_each(const K &first, const K &last, FN fn) const
+    {
+        for(auto it = lower_bound(first); it != end() && it->key < last; ++it)
+            fn(it->key, it->value);
+    }
+
+    // only a snapshot while other threads are writing
+    [[nodiscard]]
+    size_t size() const
+    {
+        int64_t size = m_size.load(std::memory_order_relaxed);
+        return size > 0 ? size : 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const { return size() == 0; }
+
+    // bytes held by the arena
+    [[nodiscard]]
+    size_t memory() const { return m_arena.memory(); }
+
+    Iterator begin() const { return Iterator(m_head[0].load(std::memory_order_acquire)); }
+    Iterator end() const { return Iterator(nullptr); }
+
+private:
+    Arena                m_arena;
+    std::atomic<Node*>   m_head[max_height];
+    std::atomic<int>     m_height{1};
+    std::atomic<int64_t> m_size{0};
+
+    // the link out of a node at a level, nullptr stands for the head
+    inline std::atomic<Node*>& link(Node *node, int level) const
+    {
+        return node ? node->m_next[level] : const_cast<std::atomic<Node*>&>(m_head[level]);
+    }
+
+    inline Node* next(Node *node, int level) const
+    {
+        return link(node, level).load(std::memory_order_acquire);
+    }
+
+    // a quarter of the nodes reach each next level
+    static int random_height()
+    {
+        static thread_local uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+
+        int height = 1;
+
+        while(height < max_height)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            if((state & 3) != 0)
+                break;
+
+            height++;
+        }
+
+        return height;
+    }
+
+    // moves pred forward at one level until succ is the first node whose key is not below key
+    void seek(const K &key, int level, Node *&pred, Node *&succ) const
+    {
+        succ = next(pred, level);
+
+        while(succ && succ->key < key)
+        {
+            pred = succ;
+            succ = next(pred, level);
+        }
+    }
+
+    // on every level the last node below key and the node after it
+    void find_preds(const K &key, Node **preds, Node **succs) const
+    {
+        Node *pred = nullptr;
+
+        for(int level = m_height.load(std::memory_order_relaxed); level < max_height; level++)
+        {
+            preds[level] = nullptr;
+            succs[level] = next(nullptr, level);
+        }
+
+        for(int level = m_height.load(std::memory_order_relaxed) - 1; level >= 0; level--)
+        {
+            Node *succ;
+
+            seek(key, level, pred, succ);
+
+            preds[level] = pred;
+            succs[level] = succ;
+        }
+    }
+
+    // the first node with the key, the newest version since inserts go in front of older ones
+    Node* newest(const K &key) const
+    {
+        Node *pred = nullptr;
+        Node *succ = nullptr;
+
+        for(int level = m_height.load(std::memory_order_acquire) - 1; level >= 0; level--)
+            seek(key, level, pred, succ);
+
+        return succ && !(key < succ->key) ? succ : nullptr;
+    }
+
+    // the last node with a key below bound, or the last node of all when bound is nullptr
+    Node* last_before(const K *bound) const
+    {
+        Node *pred = nullptr;
+
+        for(int level = m_height.load(std::memory_order_acquire) - 1; level >= 0; level--)
+        {
+            Node *succ = next(pred, level);
+
+            while(succ && (!bound || succ->key < *bound))
+            {
+                pred = succ;
+                succ = next(pred, level);
+            }
+        }
+
+        return pred;
+    }
+
+    friend class Iterator;
+};
+
+// walks level 0 and shows the newest version of every live key
+template<class K, class V>
+class SkipList<K, V>::Iterator
+{
+public:
+    explicit Iterator(Node *node) : m_node(node)
+    {
+        settle();
+    }
+
+    Node& operator*() const { return *m_node; }
+    Node* operator->() const { return m_node; }
+
+    Iterator& operator++()
+    {
+        skip_versions();
+        settle();
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator temp = *this;
+        ++*this;
+        return temp;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_node == b.m_node; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_node != b.m_node; }
+
+private:
+    Node *m_node;
+
+    // steps past every version of the current key
+    void skip_versions()
+    {
+        Node *node = m_node;
+
+        do
+            m_node = m_node->m_next[0].load(std::memory_order_acquire);
+        while(m_node && !(node->key < m_node->key));
+    }
+
+    // moves on while the newest version of the key is erased
+    void settle()
+    {
+        while(m_node && !m_node->live())
+            skip_versions();
+    }
+};
+
+// mixed read/write throughput against an RBT behind a mutex for a few read ratios
+void skip_list_bench(const size_t operations, const size_t threads = std::thread::hardware_concurrency())
+{
+    using namespace std::chrono;
+
+    const size_t keys = 1 << 20;
+
+    auto run = [&](auto &&read, auto &&write, size_t read_percent)
+    {
+        std::vector<std::thread> workers;
+        std::atomic<bool>        go{false};
+        std::atomic<size_t>      found{0};
+
+        for(size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]
+            {
+                std::mt19937_64 rng(t + 1);
+                size_t local = 0;
+
+                while(!go.load(std::memory_order_acquire));
+
+                for(size_t i = 0; i < operations / threads; i++)
+                {
+                    uint64_t key = rng() % keys;
+
+                    if(rng() % 100 < read_percent)
+                        local += read(key);
+                    else
+                        write(key);
+                }
+
+                found.fetch_add(local, std::memory_order_relaxed);
+            });
+        }
+
+        auto start = steady_clock::now();
+
+        go.store(true, std::memory_order_release);
+
+        for(auto &worker : workers)
+            worker.join();
+
+        auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+        return size_t(double(operations) / elapsed);
+    };
+
+    for(size_t read_percent : {50, 90, 99})
+    {
+        SkipList<uint64_t, uint64_t> list;
+        RBT<uint64_t, uint64_t>      tree;
+        std::mutex                   mutex;
+
+        // half the key space is there before the clock starts
+        for(uint64_t key = 0; key < keys; key += 2)
+        {
+            list.insert(key, key);
+            tree.insert(key, key);
+        }
+
+        size_t list_rate = run(
+                [&](uint64_t key) { return list.contains(key); },
+                [&](uint64_t key) { list.insert(key, key); },
+                read_percent);
+
+        size_t tree_rate = run(
+                [&](uint64_t key) { std::lock_guard lock(mutex); return tree.contains(key); },
+                [&](uint64_t key) { std::lock_guard lock(mutex); tree.insert(key, key); },
+                read_percent);
+
+        std::cout
+                << threads << " threads, " << read_percent << "% reads, ops/s\n"
+                << "  SkipList:    " << list_rate << '\n'
+                << "  mutex + RBT: " << tree_rate << '\n';
+    }
+}
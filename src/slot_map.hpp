@@ -0,0 +1,402 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "vector.hpp"
+#include "map.hpp"
+
+// handle to an item of a SlotMap, it stays valid until that item is erased and never refers to anything after
+// the slot it names can be reused but the generation it carries will not match again
+struct Handle
+{
+    uint32_t index      = uint32_t(-1);
+    uint32_t generation = 0;
+
+    friend bool operator==(const Handle &a, const Handle &b)
+    {
+        return a.index == b.index && a.generation == b.generation;
+    }
+
+    friend bool operator!=(const Handle &a, const Handle &b)
+    {
+        return !(a == b);
+    }
+};
+
+// values kept densely in a Vector with stable handles pointing at them through a table of slots
+// insert, erase and get are two array indexes, erase moves the last value into the hole so the values stay packed
+// and iterating them is a walk over one array, their order changes on erase
+template<typename T>
+class SlotMap
+{
+public:
+
+    SlotMap() = default;
+
+    Handle insert(const T &value)
+    {
+        m_values.push_back(value);
+        return attach();
+    }
+
+    Handle insert(T &&value)
+    {
+        m_values.push_back(std::move(value));
+        return attach();
+    }
+
+    template<class ...A>
+    Handle emplace(A &&...a)
+    {
+        m_values.push_back(T(std::forward<A>(a)...));
+        return attach();
+    }
+
+    // nullptr if the handle was erased or never came from this map
+    T* get(Handle handle)
+    {
+        size_t dense = find(handle);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    const T* get(Handle handle) const
+    {
+        size_t dense = find(handle);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    // throws if the handle is not live
+    T& at(Handle handle)
+    {
+        T *value = get(handle);
+
+        if(!value)
+            throw std::out_of_range("Handle is not in the slot map");
+
+        return *value;
+    }
+
+    bool contains(Handle handle) const
+    {
+        return find(handle) != npos;
+    }
+
+    // returns true if the value was erased
+    bool erase(Handle handle)
+    {
+        size_t dense = find(handle);
+
+        if(dense == npos)
+            return false;
+
+        size_t last = m_values.size() - 1;
+
+        if(dense != last)
+        {
+            m_values[dense] = std::move(m_values[last]);
+            m_owner[dense]  = m_owner[last];
+            m_slots[m_owner[dense]].dense = uint32_t(dense);
+        }
+
+        m_values.pop_back();
+        m_owner.pop_back();
+
+        // the slot goes to the front of the free list and every handle to it goes stale
+        Slot &slot = m_slots[handle.index];
+
+        slot.generation++;
+        slot.dense = m_free;
+        m_free     = handle.index;
+
+        return true;
+    }
+
+    // every handle goes stale, the slots are kept for reuse
+    void clear()
+    {
+        while(!m_values.empty())
+        {
+            Slot &slot = m_slots[m_owner.back()];
+
+            slot.generation++;
+            slot.dense = m_free;
+            m_free     = m_owner.back();
+
+            m_values.pop_back();
+            m_owner.pop_back();
+        }
+    }
+
+    // the handle of the value at position index of the iteration order
+    [[nodiscard]]
+    Handle handle_at(size_t index) const
+    {
+        uint32_t slot = m_owner[index];
+        return { slot, m_slots[slot].generation };
+    }
+
+    [[nodiscard]]
+    const Vector<T>& values() const { return m_values; }
+
+    [[nodiscard]]
+    T* begin() const { return m_values.begin(); }
+
+    [[nodiscard]]
+    T* end() const { return m_values.end(); }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_values.size(); }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_values.empty(); }
+
+private:
+    // dense is the value's position while the slot is used and the next free slot while it is not
+    struct Slot
+    {
+        uint32_t dense      = 0;
+        uint32_t generation = 0;
+    };
+
+    static constexpr uint32_t end_of_free = uint32_t(-1);
+
+    Vector<T>        m_values;
+    Vector<uint32_t> m_owner;
+    Vector<Slot>     m_slots;
+    uint32_t         m_free = end_of_free;
+
+    inline size_t find(Handle handle) const
+    {
+        if(handle.index >= m_slots.size())
+            return npos;
+
+        const Slot &slot = m_slots[handle.index];
+
+        // a free slot has moved on to a newer generation than any handle given out for it
+        if(slot.generation != handle.generation)
+            return npos;
+
+        return slot.dense;
+    }
+
+    // hooks the value just pushed to a free slot, or a new one
+    Handle attach()
+    {
+        uint32_t dense = uint32_t(m_values.size() - 1);
+        uint32_t index;
+
+        if(m_free != end_of_free)
+        {
+            index  = m_free;
+            m_free = m_slots[index].dense;
+        }
+        else
+        {
+            index = uint32_t(m_slots.size());
+            m_slots.push_back(Slot());
+        }
+
+        m_slots[index].dense = dense;
+        m_owner.push_back(index);
+
+        return { index, m_slots[index].generation };
+    }
+};
+
+// a map from small integer keys to values, the key indexes a sparse table that holds the value's position
+// in the dense arrays, lookups are two array indexes and the values are packed for iteration
+// the sparse table grows to the largest key so the keys should be ids handed out from 0 upward
+template<typename T>
+class SparseSet
+{
+public:
+
+    SparseSet() = default;
+
+    // replaces the value if the key is already there
+    T& set(size_t key, const T &value)
+    {
+        return set_item(key, T(value));
+    }
+
+    T& set(size_t key, T &&value)
+    {
+        return set_item(key, std::move(value));
+    }
+
+    // nullptr if the key is not there
+    T* get(size_t key)
+    {
+        size_t dense = find(key);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    const T* get(size_t key) const
+    {
+        size_t dense = find(key);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    T& operator[](size_t key)
+    {
+        T *value = get(key);
+        return value ? *value : set(key, T());
+    }
+
+    bool contains(size_t key) const
+    {
+        return find(key) != npos;
+    }
+
+    // returns true if the key was erased
+    bool erase(size_t key)
+    {
+        size_t dense = find(key);
+
+        if(dense == npos)
+            return false;
+
+        size_t last = m_keys.size() - 1;
+
+        if(dense != last)
+        {
+            m_values[dense] = std::move(m_values[last]);
+            m_keys[dense]   = m_keys[last];
+            m_sparse[m_keys[dense]] = dense;
+        }
+
+        m_sparse[key] = npos;
+
+        m_values.pop_back();
+        m_keys.pop_back();
+
+        return true;
+    }
+
+    void clear()
+    {
+        for(size_t key : m_keys)
+            m_sparse[key] = npos;
+
+        m_keys.clear();
+        m_values.clear();
+    }
+
+    // the keys in the same order as the values
+    [[nodiscard]]
+    const Vector<size_t>& keys() const { return m_keys; }
+
+    [[nodiscard]]
+    const Vector<T>& values() const { return m_values; }
+
+    [[nodiscard]]
+    T* begin() const { return m_values.begin(); }
+
+    [[nodiscard]]
+    T* end() const { return m_values.end(); }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_keys.size(); }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_keys.empty(); }
+
+private:
+    Vector<size_t> m_sparse;
+    Vector<size_t> m_keys;
+    Vector<T>      m_values;
+
+    inline size_t find(size_t key) const
+    {
+        return key < m_sparse.size() ? m_sparse[key] : npos;
+    }
+
+    T& set_item(size_t key, T &&value)
+    {
+        size_t dense = find(key);
+
+        if(dense != npos)
+            return m_values[dense] = std::move(value);
+
+        if(key >= m_sparse.size())
+        {
+            m_sparse.reserve(key + key / 2 + 2);
+
+            while(m_sparse.size() <= key)
+                m_sparse.push_back(npos);
+        }
+
+        m_sparse[key] = m_keys.size();
+        m_keys.push_back(key);
+        m_values.push_back(std::move(value));
+
+        return m_values.back();
+    }
+};
+
+// looking up every entity by id in a Map against a SlotMap handle and a SparseSet key
+void slot_map_bench(const size_t items = 1 << 18)
+{
+    using namespace std::chrono;
+
+    Map<size_t, uint64_t>  map;
+    SlotMap<uint64_t>      slots;
+    SparseSet<uint64_t>    sparse;
+    Vector<Handle>         handles;
+
+    handles.reserve(items + 1);
+
+    for(size_t i = 0; i < items; i++)
+    {
+        map.set(i, uint64_t(i));
+        handles.push_back(slots.insert(uint64_t(i)));
+        sparse.set(i, uint64_t(i));
+    }
+
+    Vector<size_t> order;
+    order.reserve(items + 1);
+
+    for(size_t i = 0; i < items; i++)
+        order.push_back(size_t(rand()) % items);
+
+    auto time = [&](auto fn)
+    {
+        auto start = steady_clock::now();
+
+        uint64_t total = 0;
+
+        for(size_t id : order)
+            total += fn(id);
+
+        return std::pair(duration_cast<duration<double>>(steady_clock::now() - start).count(), total);
+    };
+
+    auto [map_time, map_total]       = time([&](size_t id) { return *map.get(id); });
+    auto [slot_time, slot_total]     = time([&](size_t id) { return *slots.get(handles[id]); });
+    auto [sparse_time, sparse_total] = time([&](size_t id) { return *sparse.get(id); });
+
+    auto start = steady_clock::now();
+
+    uint64_t walked = 0;
+
+    for(uint64_t value : slots)
+        walked += value;
+
+    auto walk_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    bool same = map_total == slot_total && map_total == sparse_total && walked == uint64_t(items) * (items - 1) / 2;
+
+    std::cout
+            << items << " entities, random lookups" << (same ? "" : " MISMATCH") << '\n'
+            << "  Map:       " << map_time * 1e9 / double(items) << " ns/lookup\n"
+            << "  SlotMap:   " << slot_time * 1e9 / double(items) << " ns/lookup\n"
+            << "  SparseSet: " << sparse_time * 1e9 / double(items) << " ns/lookup\n"
+            << "  iterating the SlotMap: " << walk_time * 1e9 / double(items) << " ns/item\n";
+}
@@ -0,0 +1,523 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "common.hpp"
+#include "vector.hpp"
+
+// the Vector api with the first N items stored inside the object, the heap is only touched once it grows past N
+// items are constructed when they are added and destroyed when they are removed, so T needs no default constructor
+// moving a SmallVector that is still inline moves its items one by one, a spilled one hands over its buffer
+template<typename T, size_t N = 8>
+class SmallVector
+{
+    static_assert(N > 0, "SmallVector needs room for at least one inline item");
+
+public:
+
+    SmallVector() = default;
+
+    SmallVector(std::initializer_list<T> items)
+    {
+        reserve(items.size());
+
+        for(auto &item : items)
+            new (m_data + m_size++) T(item);
+    }
+
+    SmallVector(const SmallVector& other)
+    {
+        copy_from(other);
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        move_from(std::move(other));
+    }
+
+    ~SmallVector()
+    {
+        destroy();
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if(this != &other)
+        {
+            clear();
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if(this != &other)
+        {
+            destroy();
+            move_from(std::move(other));
+        }
+
+        return *this;
+    }
+
+    // never shrinks, the items move to a heap buffer of exactly amount slots
+    void reserve(size_t amount)
+    {
+        if(amount <= m_capacity)
+            return;
+
+        T *temp = static_cast<T*>(::operator new(amount * sizeof(T), std::align_val_t(alignof(T))));
+
+        relocate(m_data, temp, m_size);
+        release();
+
+        m_data     = temp;
+        m_capacity = amount;
+    }
+
+    // moves the items back inside the object if they fit, otherwise into a buffer of exactly size() slots
+    void shrink_to_fit()
+    {
+        if(is_inline() || m_size == m_capacity)
+            return;
+
+        T *temp = m_size <= N
+                ? inline_data()
+                : static_cast<T*>(::operator new(m_size * sizeof(T), std::align_val_t(alignof(T))));
+
+        relocate(m_data, temp, m_size);
+        release();
+
+        m_data     = temp;
+        m_capacity = m_size <= N ? N : m_size;
+    }
+
+    // keeps the buffer, inline or not
+    void clear()
+    {
+        std::destroy_n(m_data, m_size);
+        m_size = 0;
+    }
+
+    void push_back(const T& item)
+    {
+        if(m_size == m_capacity)
+        {
+            // item may live in the buffer that is about to move
+            T copy(item);
+            grow(m_size + 1);
+            new (m_data + m_size++) T(std::move(copy));
+            return;
+        }
+
+        new (m_data + m_size++) T(item);
+    }
+
+    void push_back(T&& item)
+    {
+        if(m_size == m_capacity)
+        {
+            T moved(std::move(item));
+            grow(m_size + 1);
+            new (m_data + m_size++) T(std::move(moved));
+            return;
+        }
+
+        new (m_data + m_size++) T(std::move(item));
+    }
+
+    template<typename... A>
+        requires (sizeof...(A) > 0)
+    void push_back(const T& item, const A& ...a)
+    {
+        push_back(item);
+        (push_back(a), ...);
+    }
+
+    // constructs the item in place from the arguments
+    template<typename... A>
+    T& emplace_back(A&& ...a)
+    {
+        if(m_size == m_capacity)
+        {
+            T item(std::forward<A>(a)...);
+            grow(m_size + 1);
+            return *new (m_data + m_size++) T(std::move(item));
+        }
+
+        return *new (m_data + m_size++) T(std::forward<A>(a)...);
+    }
+
+    void pop_back()
+    {
+        if(empty())
+            return;
+
+        std::destroy_at(m_data + --m_size);
+    }
+
+    // swaps the index of a and b
+    inline void swap(size_t a, size_t b)
+    {
+        if(a >= m_size || b >= m_size)
+            return;
+
+        std::swap(m_data[a], m_data[b]);
+    }
+
+    // swaps the desired index to the last index and pops it
+    void swap_pop(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        if(index != m_size - 1)
+            m_data[index] = std::move(m_data[m_size - 1]);
+
+        pop_back();
+    }
+
+    void insert(size_t index, const T& item)
+    {
+        if(index > m_size)
+            return;
+
+        if(index == m_size)
+        {
+            push_back(item);
+            return;
+        }
+
+        T copy(item);
+
+        if(m_size == m_capacity)
+            grow(m_size + 1);
+
+        // the last item moves into the free slot, the rest shift up by assignment
+        new (m_data + m_size) T(std::move(m_data[m_size - 1]));
+
+        for(size_t i = m_size - 1; i > index; i--)
+            m_data[i] = std::move(m_data[i - 1]);
+
+        m_data[index] = std::move(copy);
+        m_size++;
+    }
+
+    void erase(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        for(size_t i = index; i + 1 < m_size; i++)
+            m_data[i] = std::move(m_data[i + 1]);
+
+        pop_back();
+    }
+
+    // takes a filter function for every item if it returns false that item will be filtered
+    // the kept items are compacted in place, nothing is allocated
+    template<typename FN>
+    void filter(FN fn)
+    {
+        size_t kept = 0;
+
+        for(size_t i = 0; i < m_size; i++)
+        {
+            if(!fn(m_data[i]))
+                continue;
+
+            if(kept != i)
+                m_data[kept] = std::move(m_data[i]);
+
+            kept++;
+        }
+
+        std::destroy_n(m_data + kept, m_size - kept);
+        m_size = kept;
+    }
+
+    // copies of the items in [start, end)
+    SmallVector slice(size_t start, size_t end) const
+    {
+        SmallVector output;
+
+        if(end > m_size)
+            end = m_size;
+        if(start >= end)
+            return output;
+
+        output.reserve(end - start);
+
+        for(; start < end; start++)
+            new (output.m_data + output.m_size++) T(m_data[start]);
+
+        return output;
+    }
+
+    // returns true if every item in the vector satisfies the provided function
+    template<typename FN>
+    inline bool every(FN fn) const
+    {
+        return container::every(*this, fn);
+    }
+
+    inline bool includes(const T& item) const
+    {
+        return container::includes(*this, item);
+    }
+
+    inline void fill(size_t start, size_t end, const T& item)
+    {
+        container::fill(*this, start, end, item);
+    }
+
+    // npos if item is not there
+    size_t index_of(const T& item, size_t offset = 0) const
+    {
+        return container::index_of(*this, item, offset);
+    }
+
+    template<typename FN>
+    void map(FN fn)
+    {
+        container::map(*this, fn);
+    }
+
+    template<typename FN>
+    void each(FN fn) const
+    {
+        container::each(*this, fn);
+    }
+
+    T sum() const
+    {
+        return container::sum(*this);
+    }
+
+    // throws if the vector is empty
+    T min() const
+    {
+        return container::min(*this);
+    }
+
+    T max() const
+    {
+        return container::max(*this);
+    }
+
+    size_t count(const T& item) const
+    {
+        return container::count(*this, item);
+    }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b)
+    {
+        if(a.size() != b.size())
+            return false;
+
+        for(size_t i = 0; i < a.size(); i++)
+        {
+            if(!(a.m_data[i] == b.m_data[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    friend bool operator!=(const SmallVector& a, const SmallVector& b)
+    {
+        return !(a == b);
+    }
+
+    T& operator[](size_t index) { return get_element(index); }
+
+    const T& operator[](size_t index) const { return get_element(index); }
+
+    friend std::ostream& operator<<(std::ostream& os, const SmallVector& vec)
+    {
+        return os << to_string(vec);
+    }
+
+    [[nodiscard]]
+    T* begin() { return m_data; }
+
+    [[nodiscard]]
+    T* end() { return m_data + m_size; }
+
+    [[nodiscard]]
+    const T* begin() const { return m_data; }
+
+    [[nodiscard]]
+    const T* end() const { return m_data + m_size; }
+
+    [[nodiscard]]
+    T& front() { return get_element(0); }
+
+    [[nodiscard]]
+    const T& front() const { return get_element(0); }
+
+    [[nodiscard]]
+    T& back() { return get_element(m_size - 1); }
+
+    [[nodiscard]]
+    const T& back() const { return get_element(m_size - 1); }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    inline size_t capacity() const { return m_capacity; }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_size == 0; }
+
+    // true while the items are stored inside the object
+    [[nodiscard]]
+    inline bool is_inline() const { return m_data == inline_data(); }
+
+    [[nodiscard]]
+    inline T *data() { return m_data; }
+
+    [[nodiscard]]
+    inline const T *data() const { return m_data; }
+
+private:
+    alignas(T) unsigned char m_inline[N * sizeof(T)];
+
+    T      *m_data     = inline_data();
+    size_t  m_size     = 0;
+    size_t  m_capacity = N;
+
+    inline T* inline_data() { return reinterpret_cast<T*>(m_inline); }
+
+    inline const T* inline_data() const { return reinterpret_cast<const T*>(m_inline); }
+
+    inline T& get_element(size_t index)
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return m_data[index];
+    }
+
+    inline const T& get_element(size_t index) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return m_data[index];
+    }
+
+    // at least doubles the capacity so a run of push_back is amortized constant
+    inline void grow(size_t needed)
+    {
+        if(needed <= m_capacity)
+            return;
+
+        reserve(needed > m_capacity * 2 ? needed : m_capacity * 2);
+    }
+
+    // move constructs count items into uninitialized memory and destroys the originals
+    static void relocate(T *from, T *to, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            new (to + i) T(std::move_if_noexcept(from[i]));
+            std::destroy_at(from + i);
+        }
+    }
+
+    // frees the heap buffer if there is one, the items have to be gone already
+    inline void release()
+    {
+        if(!is_inline())
+            ::operator delete(m_data, std::align_val_t(alignof(T)));
+
+        m_data     = inline_data();
+        m_capacity = N;
+    }
+
+    inline void destroy()
+    {
+        clear();
+        release();
+    }
+
+    // this has to be empty and inline
+    void copy_from(const SmallVector& other)
+    {
+        reserve(other.m_size);
+
+        for(size_t i = 0; i < other.m_size; i++)
+        {
+            new (m_data + i) T(other.m_data[i]);
+            m_size = i + 1;
+        }
+    }
+
+    // this has to be empty and inline, other is left empty and inline
+    void move_from(SmallVector&& other)
+    {
+        if(other.is_inline())
+        {
+            relocate(other.m_data, m_data, other.m_size);
+            m_size = other.m_size;
+            other.m_size = 0;
+            return;
+        }
+
+        m_data     = other.m_data;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_data     = other.inline_data();
+        other.m_size     = 0;
+        other.m_capacity = N;
+    }
+};
+
+// many short lived vectors of a handful of items, the case SmallVector exists for
+void small_vector_bench(const size_t vectors = 1 << 20, const size_t items = 6)
+{
+    using namespace std::chrono;
+
+    auto run = [&]<typename V>()
+    {
+        uint64_t check = 0;
+
+        auto start = steady_clock::now();
+
+        for(size_t i = 0; i < vectors; i++)
+        {
+            V v;
+
+            for(size_t j = 0; j < items; j++)
+                v.push_back(uint64_t(i + j));
+
+            check += v[items - 1];
+        }
+
+        auto time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+        return std::pair(time, check);
+    };
+
+    auto [vector_time, vector_check] = run.template operator()<Vector<uint64_t>>();
+    auto [small_time, small_check]   = run.template operator()<SmallVector<uint64_t, 8>>();
+
+    std::cout
+            << vectors << " vectors of " << items << " items" << (vector_check == small_check ? "" : " MISMATCH") << '\n'
+            << "  Vector:         " << vector_time * 1e9 / double(vectors) << " ns/vector\n"
+            << "  SmallVector<8>: " << small_time * 1e9 / double(vectors) << " ns/vector\n";
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "common.hpp"
+#include "record.hpp"
+
+// a vector of rows where every field lives in its own array, a loop over one field only reads that field
+// and the column is a plain array of numbers the vectorized container:: algorithms run on
+//
+//     SoAVector<uint64_t, double> rows;
+//     rows.push_back(Record(id, price));
+//     double total = container::sum(rows.column<1>());
+//     auto [id, price] = rows[0];
+//
+// rows are handed out as a tuple of references into the columns, they stay valid until the vector grows
+// every column starts on a cache line so loads of one never share a line with another
+template<typename... Fields>
+class SoAVector
+{
+    static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+public:
+    using value_type = std::tuple<Fields...>;
+    using reference  = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+
+    template<size_t I>
+    using field = std::tuple_element_t<I, value_type>;
+
+    SoAVector() = default;
+
+    SoAVector(const SoAVector& other)
+    {
+        copy_from(other);
+    }
+
+    SoAVector(SoAVector&& other) noexcept
+    {
+        move_from(std::move(other));
+    }
+
+    ~SoAVector()
+    {
+        destroy();
+    }
+
+    SoAVector& operator=(const SoAVector& other)
+    {
+        if(this != &other)
+        {
+            clear();
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& other) noexcept
+    {
+        if(this != &other)
+        {
+            destroy();
+            move_from(std::move(other));
+        }
+
+        return *this;
+    }
+
+    void reserve(size_t amount)
+    {
+        if(amount <= m_capacity)
+            return;
+
+        for_columns([&]<size_t I>(auto *&column)
+        {
+            using F = field<I>;
+
+            F *temp = allocate<F>(amount);
+
+            for(size_t i = 0; i < m_size; i++)
+            {
+                new (temp + i) F(std::move_if_noexcept(column[i]));
+                std::destroy_at(column + i);
+            }
+
+            deallocate(column);
+            column = temp;
+        });
+
+        m_capacity = amount;
+    }
+
+    void clear()
+    {
+        for_columns([&]<size_t I>(auto *column) { std::destroy_n(column, m_size); });
+        m_size = 0;
+    }
+
+    void push_back(const Fields& ...fields)
+    {
+        emplace_row(fields...);
+    }
+
+    void push_back(Fields&& ...fields)
+    {
+        emplace_row(std::move(fields)...);
+    }
+
+    void push_back(const value_type& row)
+    {
+        std::apply([&](const Fields& ...fields) { emplace_row(fields...); }, row);
+    }
+
+    void push_back(value_type&& row)
+    {
+        std::apply([&](Fields& ...fields) { emplace_row(std::move(fields)...); }, row);
+    }
+
+    // a Record goes in as two columns, the key and the value
+    template<typename K, typename V>
+        requires std::is_same_v<std::tuple<K, V>, value_type>
+    void push_back(const Record<K, V>& record)
+    {
+        emplace_row(record.key, record.value);
+    }
+
+    template<typename K, typename V>
+        requires std::is_same_v<std::tuple<K, V>, value_type>
+    void push_back(Record<K, V>&& record)
+    {
+        emplace_row(std::move(record.key), std::move(record.value));
+    }
+
+    void pop_back()
+    {
+        if(empty())
+            return;
+
+        m_size--;
+        for_columns([&]<size_t I>(auto *column) { std::destroy_at(column + m_size); });
+    }
+
+    // swaps the desired index to the last index and pops it
+    void swap_pop(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        if(index != m_size - 1)
+            for_columns([&]<size_t I>(auto *column) { column[index] = std::move(column[m_size - 1]); });
+
+        pop_back();
+    }
+
+    void erase(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        for_columns([&]<size_t I>(auto *column)
+        {
+            for(size_t i = index; i + 1 < m_size; i++)
+                column[i] = std::move(column[i + 1]);
+        });
+
+        pop_back();
+    }
+
+    // keeps the rows fn returns true for, fn gets the row as a tuple of references
+    template<typename FN>
+    void filter(FN fn)
+    {
+        compact([&](size_t i) { return fn(row(i)); });
+    }
+
+    // keeps the rows where fn returns true for field I, only that column is read to decide
+    template<size_t I, typename FN>
+    void filter_by(FN fn)
+    {
+        const auto *column = std::get<I>(m_columns);
+
+        compact([&](size_t i) { return fn(column[i]); });
+    }
+
+    // one field of every row as a contiguous array
+    template<size_t I>
+    [[nodiscard]]
+    std::span<field<I>> column()
+    {
+        return { std::get<I>(m_columns), m_size };
+    }
+
+    template<size_t I>
+    [[nodiscard]]
+    std::span<const field<I>> column() const
+    {
+        return { std::get<I>(m_columns), m_size };
+    }
+
+    // the field I of every row added up
+    template<size_t I>
+    [[nodiscard]]
+    field<I> sum() const
+    {
+        return m_size ? container::sum(column<I>()) : field<I>();
+    }
+
+    [[nodiscard]]
+    reference operator[](size_t index) { return row(check(index)); }
+
+    [[nodiscard]]
+    const_reference operator[](size_t index) const { return row(check(index)); }
+
+    [[nodiscard]]
+    reference front() { return row(check(0)); }
+
+    [[nodiscard]]
+    reference back() { return row(check(m_size - 1)); }
+
+    // walks the rows, dereferencing gives a reference so structured bindings write through to the columns
+    template<bool Const>
+    class Iterator
+    {
+    public:
+        using owner = std::conditional_t<Const, const SoAVector, SoAVector>;
+
+        Iterator(owner *vec, size_t index) : m_vec(vec), m_index(index) {}
+
+        auto operator*() const { return m_vec->row(m_index); }
+
+        Iterator& operator++() { m_index++; return *this; }
+
+        Iterator operator++(int) { Iterator old = *this; m_index++; return old; }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_index == b.m_index; }
+
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_index != b.m_index; }
+
+    private:
+        owner  *m_vec;
+        size_t  m_index;
+    };
+
+    [[nodiscard]]
+    Iterator<false> begin() { return { this, 0 }; }
+
+    [[nodiscard]]
+    Iterator<false> end() { return { this, m_size }; }
+
+    [[nodiscard]]
+    Iterator<true> begin() const { return { this, 0 }; }
+
+    [[nodiscard]]
+    Iterator<true> end() const { return { this, m_size }; }
+
+    [[nodiscard]]
+    inline size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    inline size_t capacity() const { return m_capacity; }
+
+    [[nodiscard]]
+    inline bool empty() const { return m_size == 0; }
+
+private:
+    std::tuple<Fields*...> m_columns{};
+    size_t                 m_size     = 0;
+    size_t                 m_capacity = 0;
+
+    template<typename F>
+    static F* allocate(size_t count)
+    {
+        return static_cast<F*>(::operator new(count * sizeof(F), std::align_val_t(alignof(F) > cache_line ? alignof(F) : cache_line)));
+    }
+
+    template<typename F>
+    static void deallocate(F *column)
+    {
+        if(column)
+            ::operator delete(column, std::align_val_t(alignof(F) > cache_line ? alignof(F) : cache_line));
+    }
+
+    // fn is called once per column with the column index as a template argument
+    template<typename FN>
+    void for_columns(FN &&fn)
+    {
+        [&]<size_t... I>(std::index_sequence<I...>)
+        {
+            (fn.template operator()<I>(std::get<I>(m_columns)), ...);
+        }(std::index_sequence_for<Fields...>());
+    }
+
+    inline size_t check(size_t index) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return index;
+    }
+
+    inline reference row(size_t index)
+    {
+        return std::apply([&](Fields* ...columns) { return reference(columns[index]...); }, m_columns);
+    }
+
+    inline const_reference row(size_t index) const
+    {
+        return std::apply([&](Fields* ...columns) { return const_reference(columns[index]...); }, m_columns);
+    }
+
+    template<typename... A>
+    void emplace_row(A&& ...fields)
+    {
+        if(m_size == m_capacity)
+        {
+            // the fields may be references into the columns that are about to move
+            value_type copy(std::forward<A>(fields)...);
+
+            reserve(m_capacity ? m_capacity * 2 : 16);
+
+            std::apply([&](Fields& ...moved) { construct_row(std::move(moved)...); }, copy);
+            return;
+        }
+
+        construct_row(std::forward<A>(fields)...);
+    }
+
+    template<typename... A>
+    void construct_row(A&& ...fields)
+    {
+        [&]<size_t... I>(std::index_sequence<I...>)
+        {
+            (new (std::get<I>(m_columns) + m_size) field<I>(std::forward<A>(fields)), ...);
+        }(std::index_sequence_for<Fields...>());
+
+        m_size++;
+    }
+
+    // moves the rows keep returns true for to the front of every column
+    template<typename Keep>
+    void compact(Keep keep)
+    {
+        size_t kept = 0;
+
+        for(size_t i = 0; i < m_size; i++)
+        {
+            if(!keep(i))
+                continue;
+
+            if(kept != i)
+                for_columns([&]<size_t I>(auto *column) { column[kept] = std::move(column[i]); });
+
+            kept++;
+        }
+
+        for_columns([&]<size_t I>(auto *column) { std::destroy_n(column + kept, m_size - kept); });
+        m_size = kept;
+    }
+
+    inline void destroy()
+    {
+        clear();
+        for_columns([&]<size_t I>(auto *&column) { deallocate(column); column = nullptr; });
+        m_capacity = 0;
+    }
+
+    // this has to be empty
+    void copy_from(const SoAVector& other)
+    {
+        reserve(other.m_size);
+
+        for(size_t i = 0; i < other.m_size; i++)
+            std::apply([&](const Fields& ...fields) { construct_row(fields...); }, other.row(i));
+    }
+
+    // this has to be empty and unallocated
+    void move_from(SoAVector&& other)
+    {
+        m_columns  = other.m_columns;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+
+        other.m_columns  = {};
+        other.m_size     = 0;
+        other.m_capacity = 0;
+    }
+};
+
+// summing and filtering on the value of key value rows, stored as records against stored as columns
+void soa_bench(const size_t items = 1 << 22)
+{
+    using namespace std::chrono;
+
+    std::vector<Record<uint64_t, uint64_t>> records;
+    SoAVector<uint64_t, uint64_t>      columns;
+
+    records.reserve(items);
+    columns.reserve(items);
+
+    for(size_t i = 0; i < items; i++)
+    {
+        uint64_t value = uint64_t(rand());
+
+        records.emplace_back(i, value);
+        columns.push_back(i, value);
+    }
+
+    auto start = steady_clock::now();
+
+    uint64_t record_sum = 0;
+
+    for(auto &record : records)
+        record_sum += record.value;
+
+    auto record_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+
+    uint64_t column_sum = columns.sum<1>();
+
+    auto column_time = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    uint64_t limit = RAND_MAX / 2;
+
+    start = steady_clock::now();
+
+    std::erase_if(records, [&](const Record<uint64_t, uint64_t> &record) { return record.value >= limit; });
+
+    auto record_filter = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+
+    columns.filter_by<1>([&](uint64_t value) { return value < limit; });
+
+    auto column_filter = duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+    bool same = record_sum == column_sum && records.size() == columns.size();
+
+    std::cout
+            << items << " rows of two uint64_t" << (same ? "" : " MISMATCH") << '\n'
+            << "  vector<Record> sum:    " << record_time * 1e9 / double(items) << " ns/row\n"
+            << "  SoAVector sum:         " << column_time * 1e9 / double(items) << " ns/row\n"
+            << "  vector<Record> filter: " << record_filter * 1e9 / double(items) << " ns/row\n"
+            << "  SoAVector filter:      " << column_filter * 1e9 / double(items) << " ns/row\n";
+}
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <bit>
+#include <utility>
+
 #include "util.hpp"
+#include "vector.hpp"
+#include "sorting_network.hpp"
 
 constexpr auto descending = [](auto &a, auto &b) { return a < b; };
 constexpr auto ascending  = [](auto &a, auto &b) { return a > b; };
 
 template<is_container C, typename FN>
-void selection_sort(C& container, FN fn)
+constexpr void selection_sort(C& container, FN fn)
 {
     for(auto begin = container.begin(); begin != container.end(); begin++)
     {
@@ -23,23 +28,311 @@ void selection_sort(C& container, FN fn)
 }
 
 template<is_container C, typename FN>
-void insertion_sort(C& container, FN fn)
+constexpr void insertion_sort(C& container, FN fn)
 {
-    if(container.size() == 1)
+    if(container.size() < 2)
         return;
 
     for(auto current = container.begin()+1; current != container.end(); current++)
     {
-        auto key = *current;
-        auto start = current-1;
+        auto key  = std::move(*current);
+        auto hole = current;
+
+        // moves the hole down rather than a pointer below it, stepping before begin is undefined
+        while(hole != container.begin() && fn(key, *(hole-1)))
+        {
+            *hole = std::move(*(hole-1));
+            --hole;
+        }
+
+        *hole = std::move(key);
+    }
+}
+
+
+// heap helpers shared by the selection algorithms, the root is the item that orders last under fn
+template<typename It, typename FN>
+constexpr void heap_sift_down(It first, size_t size, size_t index, FN fn)
+{
+    auto item = std::move(first[index]);
+
+    while(true)
+    {
+        size_t child = index * 2 + 1;
+
+        if(child >= size)
+            break;
+
+        if(child + 1 < size && fn(first[child], first[child + 1]))
+            child++;
+
+        if(!fn(item, first[child]))
+            break;
+
+        first[index] = std::move(first[child]);
+        index = child;
+    }
+
+    first[index] = std::move(item);
+}
+
+template<typename It, typename FN>
+constexpr void heap_make(It first, size_t size, FN fn)
+{
+    for(size_t i = size / 2; i-- > 0;)
+        heap_sift_down(first, size, i, fn);
+}
+
+template<typename It, typename FN>
+constexpr void heap_select(It first, size_t k, size_t size, FN fn)
+{
+    heap_make(first, k, fn);
+
+    for(size_t i = k; i < size; i++)
+    {
+        if(fn(first[i], first[0]))
+        {
+            std::swap(first[i], first[0]);
+            heap_sift_down(first, k, 0, fn);
+        }
+    }
+}
+
+// orders the first k items and leaves the rest in an unspecified order
+template<is_container C, typename FN>
+constexpr void partial_sort(C& container, size_t k, FN fn)
+{
+    size_t size = container.size();
+
+    if(k > size)
+        k = size;
+    if(k == 0)
+        return;
+
+    auto first = container.begin();
+
+    heap_select(first, k, size, fn);
+
+    for(size_t i = k - 1; i > 0; i--)
+    {
+        std::swap(first[0], first[i]);
+        heap_sift_down(first, i, 0, fn);
+    }
+}
+
+// introselect, quickselect until the recursion budget runs out and heap selection after that
+// afterwards the nth item is where a full sort would put it, nothing before it orders after it and nothing after it orders before it
+template<is_container C, typename FN>
+constexpr void nth_element(C& container, size_t n, FN fn)
+{
+    size_t size = container.size();
+
+    if(n >= size)
+        return;
+
+    auto   first  = container.begin();
+    size_t budget = 2 * std::bit_width(size);
+
+    while(size > 16)
+    {
+        if(budget-- == 0)
+        {
+            heap_select(first, n + 1, size, fn);
+            std::swap(first[0], first[n]);
+            return;
+        }
+
+        size_t middle = size / 2;
+
+        // median of three ends up at the back and serves as the pivot
+        if(fn(first[middle], first[0]))
+            std::swap(first[middle], first[0]);
+        if(fn(first[size - 1], first[0]))
+            std::swap(first[size - 1], first[0]);
+        if(fn(first[middle], first[size - 1]))
+            std::swap(first[middle], first[size - 1]);
+
+        auto &pivot = first[size - 1];
+
+        size_t i = 0;
+        size_t j = size - 2;
+
+        while(true)
+        {
+            while(fn(first[i], pivot))
+                i++;
+            while(j > i && fn(pivot, first[j]))
+                j--;
+
+            if(i >= j)
+                break;
+
+            std::swap(first[i], first[j]);
+
+            i++;
+            j--;
+        }
+
+        std::swap(first[i], first[size - 1]);
+
+        if(i == n)
+            return;
 
-        while(start+1 != container.begin() && fn(key, *start))
+        if(n < i)
         {
-            *(start+1) = std::move(*start);
-            --start;
+            size = i;
         }
+        else
+        {
+            first += i + 1;
+            n     -= i + 1;
+            size  -= i + 1;
+        }
+    }
+
+    for(size_t i = 1; i < size; i++)
+    {
+        auto key = std::move(first[i]);
+        size_t j = i;
+
+        for(; j > 0 && fn(key, first[j - 1]); j--)
+            first[j] = std::move(first[j - 1]);
+
+        first[j] = std::move(key);
+    }
+}
+
+// insertion sort for short runs, a heap sort otherwise, both work in constant expressions so a table can be sorted at compile time
+//
+//     constexpr auto table = [] { Array<int, 4> a{ 3, 1, 4, 2 }; sort(a, descending); return a; }();
+template<is_container C, typename FN>
+constexpr void sort(C& container, FN fn)
+{
+    if(container.size() <= 16)
+        insertion_sort(container, fn);
+    else
+        partial_sort(container, container.size(), fn);
+}
+
+// index of the first item that does not order before item, size() if there is none, the container has to be sorted by fn
+template<is_container C, typename T, typename FN>
+constexpr size_t lower_bound(const C& container, const T& item, FN fn)
+{
+    auto   first = container.begin();
+    size_t low   = 0;
+    size_t size  = container.size();
+
+    while(size > 0)
+    {
+        size_t half = size / 2;
 
-        *(start+1) = std::move(key);
+        if(fn(first[low + half], item))
+        {
+            low  += half + 1;
+            size -= half + 1;
+        }
+        else
+        {
+            size = half;
+        }
     }
+
+    return low;
+}
+
+template<is_container C, typename T, typename FN>
+constexpr bool binary_search(const C& container, const T& item, FN fn)
+{
+    size_t index = lower_bound(container, item, fn);
+
+    return index < container.size() && !fn(item, container.begin()[index]);
 }
 
+// keeps the k items that order first out of everything pushed into it, in O(k) memory
+template<typename T, typename FN>
+class TopK
+{
+public:
+
+    TopK(size_t k, FN fn) : m_k(k), m_fn(fn)
+    {
+        m_heap.reserve(k + 1);
+    }
+
+    void push(const T& item)
+    {
+        if(m_k == 0)
+            return;
+
+        if(m_heap.size() < m_k)
+        {
+            m_heap.push_back(item);
+            sift_up(m_heap.size() - 1);
+            return;
+        }
+
+        if(m_fn(item, m_heap[0]))
+        {
+            m_heap[0] = item;
+            heap_sift_down(m_heap.begin(), m_heap.size(), 0, m_fn);
+        }
+    }
+
+    template<is_container C>
+    void push_all(const C& container)
+    {
+        for(auto &item : container)
+            push(item);
+    }
+
+    // the item that would be evicted next
+    [[nodiscard]]
+    const T& threshold() const { return m_heap[0]; }
+
+    // the kept items in heap order
+    [[nodiscard]]
+    const Vector<T>& items() const { return m_heap; }
+
+    Vector<T> sorted() const
+    {
+        Vector<T> output = m_heap;
+        partial_sort(output, output.size(), m_fn);
+        return output;
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_heap.size(); }
+
+    [[nodiscard]]
+    bool empty() const { return m_heap.empty(); }
+
+private:
+    size_t    m_k;
+    FN        m_fn;
+    Vector<T> m_heap;
+
+    void sift_up(size_t index)
+    {
+        while(index > 0)
+        {
+            size_t parent = (index - 1) / 2;
+
+            if(!m_fn(m_heap[parent], m_heap[index]))
+                break;
+
+            std::swap(m_heap[parent], m_heap[index]);
+            index = parent;
+        }
+    }
+};
+
+// the k items of the container that order first, sorted
+template<is_container C, typename FN>
+auto top_k(const C& container, size_t k, FN fn)
+{
+    TopK<std::remove_cvref_t<decltype(*container.begin())>, FN> top(k, fn);
+
+    top.push_all(container);
+
+    return top.sorted();
+}
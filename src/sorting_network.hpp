@@ -0,0 +1,561 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <bit>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "util.hpp"
+#include "array.hpp"
+#include "simd.hpp"
+
+// bitonic sorting networks for small batches of 32 and 64 bit keys
+// every compare exchange is a min/max pair so nothing branches on the keys,
+// the network is compiled for avx512, avx2 and plain scalar code and simd::level() picks one at runtime
+
+namespace network
+{
+    // largest batch the network sorts directly, bigger inputs go through network_sort
+    static constexpr size_t max_size = 256;
+
+    template<typename T>
+    concept is_key = std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+    // value that sorts after every key, used to pad batches up to a power of two
+    template<is_key T>
+    constexpr T sentinel()
+    {
+        if constexpr(std::numeric_limits<T>::has_infinity)
+            return std::numeric_limits<T>::infinity();
+        return std::numeric_limits<T>::max();
+    }
+
+    template<is_key T>
+    void bitonic_scalar(T *data, size_t n)
+    {
+        for(size_t k = 2; k <= n; k <<= 1)
+        {
+            for(size_t j = k >> 1; j > 0; j >>= 1)
+            {
+                for(size_t i = 0; i < n; i++)
+                {
+                    size_t l = i ^ j;
+
+                    if(l < i)
+                        continue;
+
+                    T a = data[i];
+                    T b = data[l];
+
+                    T lo = b < a ? b : a;
+                    T hi = b < a ? a : b;
+
+                    bool up = (i & k) == 0;
+
+                    data[i] = up ? lo : hi;
+                    data[l] = up ? hi : lo;
+                }
+            }
+        }
+    }
+
+    // same network but the index travels with its key, equal keys are ordered by their index
+    template<is_key K, typename I>
+    void bitonic_scalar(K *keys, I *index, size_t n)
+    {
+        auto before = [&](size_t a, size_t b)
+        {
+            return keys[a] < keys[b] || (!(keys[b] < keys[a]) && index[a] < index[b]);
+        };
+
+        for(size_t k = 2; k <= n; k <<= 1)
+        {
+            for(size_t j = k >> 1; j > 0; j >>= 1)
+            {
+                for(size_t i = 0; i < n; i++)
+                {
+                    size_t l = i ^ j;
+
+                    if(l < i)
+                        continue;
+
+                    bool up   = (i & k) == 0;
+                    bool swap = up ? before(l, i) : before(i, l);
+
+                    K key = keys[i];
+                    I idx = index[i];
+
+                    keys[i]  = swap ? keys[l] : key;
+                    keys[l]  = swap ? key : keys[l];
+                    index[i] = swap ? index[l] : idx;
+                    index[l] = swap ? idx : index[l];
+                }
+            }
+        }
+    }
+
+    // a lane takes the min of its pair when it is the lower lane of an ascending run
+    // or the upper lane of a descending one, runs shorter than a register alternate by lane
+    constexpr bool takes_min(size_t lane, size_t j, size_t k, size_t width, bool up)
+    {
+        bool ascending = k < width ? (lane & k) == 0 : up;
+        return ((lane & j) == 0) == ascending;
+    }
+
+    // the network once per instruction set, the drivers are compiled under the same target as the lanes
+    // so the intrinsics inline into them
+
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// gcc 12 reports the undefined registers the avx512 intrinsics start from as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    namespace avx512
+    {
+        template<is_key T>
+        struct Lanes
+        {
+            using type = T;
+            using reg  = __m512i;
+            using mask = std::conditional_t<sizeof(T) == 4, __mmask16, __mmask8>;
+
+            static constexpr size_t width = 64 / sizeof(T);
+
+            static reg load(const T *p) { return _mm512_loadu_si512(p); }
+
+            static void store(T *p, reg v) { _mm512_storeu_si512(p, v); }
+
+            static reg permute(reg v, reg index)
+            {
+                if constexpr(sizeof(T) == 4)
+                    return _mm512_permutexvar_epi32(index, v);
+                else
+                    return _mm512_permutexvar_epi64(index, v);
+            }
+
+            static reg blend(reg a, reg b, mask m)
+            {
+                if constexpr(sizeof(T) == 4)
+                    return _mm512_mask_blend_epi32(m, a, b);
+                else
+                    return _mm512_mask_blend_epi64(m, a, b);
+            }
+
+            static reg partner(size_t j)
+            {
+                alignas(64) std::conditional_t<sizeof(T) == 4, int32_t, int64_t> index[width];
+
+                for(size_t i = 0; i < width; i++)
+                    index[i] = i ^ j;
+
+                return _mm512_load_si512(index);
+            }
+
+            static mask lanes(size_t j, size_t k, bool up)
+            {
+                mask bits = 0;
+
+                for(size_t i = 0; i < width; i++)
+                {
+                    if(takes_min(i, j, k, width, up))
+                        bits |= mask(1u << i);
+                }
+
+                return bits;
+            }
+
+            static reg min(reg a, reg b)
+            {
+                if constexpr(std::is_same_v<T, float>)
+                    return _mm512_castps_si512(_mm512_min_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b)));
+                else if constexpr(std::is_same_v<T, double>)
+                    return _mm512_castpd_si512(_mm512_min_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b)));
+                else if constexpr(sizeof(T) == 4)
+                    return std::is_signed_v<T> ? _mm512_min_epi32(a, b) : _mm512_min_epu32(a, b);
+                else
+                    return std::is_signed_v<T> ? _mm512_min_epi64(a, b) : _mm512_min_epu64(a, b);
+            }
+
+            static reg max(reg a, reg b)
+            {
+                if constexpr(std::is_same_v<T, float>)
+                    return _mm512_castps_si512(_mm512_max_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b)));
+                else if constexpr(std::is_same_v<T, double>)
+                    return _mm512_castpd_si512(_mm512_max_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b)));
+                else if constexpr(sizeof(T) == 4)
+                    return std::is_signed_v<T> ? _mm512_max_epi32(a, b) : _mm512_max_epu32(a, b);
+                else
+                    return std::is_signed_v<T> ? _mm512_max_epi64(a, b) : _mm512_max_epu64(a, b);
+            }
+
+            // lanes where the pair (ak, ai) orders after (bk, bi), only used with unsigned 64 bit lanes
+            static mask pair_greater(reg ak, reg ai, reg bk, reg bi)
+            {
+                return mask(_mm512_cmpgt_epu64_mask(ak, bk) | (_mm512_cmpeq_epu64_mask(ak, bk) & _mm512_cmpgt_epu64_mask(ai, bi)));
+            }
+        };
+
+#include "sorting_network_kernels.hpp"
+    }
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+    namespace avx2
+    {
+        template<is_key T>
+        struct Lanes
+        {
+            using type = T;
+            using reg  = __m256i;
+            using mask = __m256i;
+
+            static constexpr size_t width = 32 / sizeof(T);
+
+            // 64 bit lanes are moved as two 32 bit halves
+            static constexpr size_t half = sizeof(T) / 4;
+
+            static reg load(const T *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+            static void store(T *p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+            static reg permute(reg v, reg index) { return _mm256_permutevar8x32_epi32(v, index); }
+
+            // picks b where the mask is set
+            static reg blend(reg a, reg b, mask m) { return _mm256_blendv_epi8(a, b, m); }
+
+            static reg partner(size_t j)
+            {
+                alignas(32) int32_t index[8];
+
+                for(size_t i = 0; i < 8; i++)
+                    index[i] = int32_t(((i / half) ^ j) * half + i % half);
+
+                return _mm256_load_si256(reinterpret_cast<const __m256i*>(index));
+            }
+
+            static mask lanes(size_t j, size_t k, bool up)
+            {
+                alignas(32) int32_t bits[8];
+
+                for(size_t i = 0; i < 8; i++)
+                    bits[i] = takes_min(i / half, j, k, width, up) ? -1 : 0;
+
+                return _mm256_load_si256(reinterpret_cast<const __m256i*>(bits));
+            }
+
+            static reg min(reg a, reg b)
+            {
+                if constexpr(std::is_same_v<T, float>)
+                    return _mm256_castps_si256(_mm256_min_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+                else if constexpr(std::is_same_v<T, double>)
+                    return _mm256_castpd_si256(_mm256_min_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+                else if constexpr(sizeof(T) == 4 && std::is_signed_v<T>)
+                    return _mm256_min_epi32(a, b);
+                else if constexpr(sizeof(T) == 4)
+                    return _mm256_min_epu32(a, b);
+                else
+                    return blend(a, b, greater(a, b));
+            }
+
+            static reg max(reg a, reg b)
+            {
+                if constexpr(std::is_same_v<T, float>)
+                    return _mm256_castps_si256(_mm256_max_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+                else if constexpr(std::is_same_v<T, double>)
+                    return _mm256_castpd_si256(_mm256_max_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b)));
+                else if constexpr(sizeof(T) == 4 && std::is_signed_v<T>)
+                    return _mm256_max_epi32(a, b);
+                else if constexpr(sizeof(T) == 4)
+                    return _mm256_max_epu32(a, b);
+                else
+                    return blend(b, a, greater(a, b));
+            }
+
+            // avx2 has no 64 bit min/max so it is built from a compare, unsigned keys flip the sign bit first
+            static reg greater(reg a, reg b)
+            {
+                if constexpr(std::is_signed_v<T>)
+                    return _mm256_cmpgt_epi64(a, b);
+
+                const reg sign = _mm256_set1_epi64x(INT64_MIN);
+
+                return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+            }
+
+            // lanes where the pair (ak, ai) orders after (bk, bi), the key decides and the index breaks ties
+            static mask pair_greater(reg ak, reg ai, reg bk, reg bi)
+            {
+                return _mm256_or_si256(greater(ak, bk), _mm256_and_si256(_mm256_cmpeq_epi64(ak, bk), greater(ai, bi)));
+            }
+        };
+
+#include "sorting_network_kernels.hpp"
+    }
+#pragma GCC pop_options
+#endif
+
+    // sorts a power of two batch with the widest lanes the cpu has that fit in it
+    template<is_key T>
+    void sort(T *data, size_t n)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        switch(simd::level())
+        {
+            case simd::Level::AVX512:
+                if(avx512::sort(data, n))
+                    return;
+                [[fallthrough]];
+            case simd::Level::AVX2:
+                if(avx2::sort(data, n))
+                    return;
+                break;
+            default:
+                break;
+        }
+#endif
+        bitonic_scalar(data, n);
+    }
+
+    // keys and index as 64 bit lanes, a pair sorts by key and then by index
+    inline void sort_pairs(uint64_t *keys, uint64_t *index, size_t n)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        switch(simd::level())
+        {
+            case simd::Level::AVX512:
+                if(avx512::sort_pairs(keys, index, n))
+                    return;
+                [[fallthrough]];
+            case simd::Level::AVX2:
+                if(avx2::sort_pairs(keys, index, n))
+                    return;
+                break;
+            default:
+                break;
+        }
+#endif
+        bitonic_scalar(keys, index, n);
+    }
+
+    // maps a key onto an unsigned value of the same size with the same ordering
+    template<is_key K>
+    constexpr auto ordered_bits(K key)
+    {
+        using U = std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+
+        constexpr U top = U(1) << (sizeof(U) * 8 - 1);
+
+        U bits = std::bit_cast<U>(key);
+
+        if constexpr(std::is_floating_point_v<K>)
+            return U(bits & top ? ~bits : bits | top);
+        else if constexpr(std::is_signed_v<K>)
+            return U(bits ^ top);
+        else
+            return bits;
+    }
+
+    template<is_key K, typename U>
+    constexpr K from_ordered_bits(U bits)
+    {
+        static_assert(sizeof(U) == sizeof(K));
+
+        constexpr U top = U(1) << (sizeof(U) * 8 - 1);
+
+        if constexpr(std::is_floating_point_v<K>)
+            bits = bits & top ? U(bits & ~top) : U(~bits);
+        else if constexpr(std::is_signed_v<K>)
+            bits ^= top;
+
+        return std::bit_cast<K>(bits);
+    }
+}
+
+template<network::is_key T>
+void network_sort(T *data, size_t n);
+
+// sorts up to network::max_size keys in ascending order, larger inputs are handed to network_sort
+template<network::is_key T>
+void sort_network(T *data, size_t n)
+{
+    if(n < 2)
+        return;
+
+    if(n > network::max_size)
+        return network_sort(data, n);
+
+    size_t padded = std::bit_ceil(n);
+
+    if(padded == n)
+        return network::sort(data, n);
+
+    alignas(64) T buffer[network::max_size];
+
+    std::memcpy(buffer, data, n * sizeof(T));
+
+    for(size_t i = n; i < padded; i++)
+        buffer[i] = network::sentinel<T>();
+
+    network::sort(buffer, padded);
+
+    std::memcpy(data, buffer, n * sizeof(T));
+}
+
+// sorts keys and reorders index alongside them, equal keys are ordered by their index
+// 32 bit keys are packed with their index into one 64 bit lane, 64 bit keys sort in one register
+// with the index in a second one that follows every swap
+template<network::is_key K>
+void sort_network(K *keys, uint32_t *index, size_t n)
+{
+    if(n < 2)
+        return;
+
+    if(n > network::max_size)
+        throw std::out_of_range("key/index batches are limited to network::max_size");
+
+    size_t padded = std::bit_ceil(n);
+
+    if constexpr(sizeof(K) == 4)
+    {
+        alignas(64) uint64_t packed[network::max_size];
+
+        for(size_t i = 0; i < n; i++)
+            packed[i] = uint64_t(network::ordered_bits(keys[i])) << 32 | index[i];
+
+        for(size_t i = n; i < padded; i++)
+            packed[i] = UINT64_MAX;
+
+        network::sort(packed, padded);
+
+        for(size_t i = 0; i < n; i++)
+        {
+            keys[i]  = network::from_ordered_bits<K>(uint32_t(packed[i] >> 32));
+            index[i] = uint32_t(packed[i]);
+        }
+    }
+    else
+    {
+        alignas(64) uint64_t key_buffer[network::max_size];
+        alignas(64) uint64_t index_buffer[network::max_size];
+
+        for(size_t i = 0; i < n; i++)
+        {
+            key_buffer[i]   = network::ordered_bits(keys[i]);
+            index_buffer[i] = index[i];
+        }
+
+        // the padding orders after every real pair, even one whose key maps to the largest value
+        for(size_t i = n; i < padded; i++)
+        {
+            key_buffer[i]   = UINT64_MAX;
+            index_buffer[i] = UINT64_MAX;
+        }
+
+        network::sort_pairs(key_buffer, index_buffer, padded);
+
+        for(size_t i = 0; i < n; i++)
+        {
+            keys[i]  = network::from_ordered_bits<K>(key_buffer[i]);
+            index[i] = uint32_t(index_buffer[i]);
+        }
+    }
+}
+
+// the size is known at compile time so the padding is resolved statically
+template<network::is_key T, size_t N>
+void sort_network(Array<T, N> &array)
+{
+    if constexpr(N > network::max_size)
+    {
+        network_sort(array.data(), N);
+    }
+    else if constexpr(N > 1 && std::has_single_bit(N))
+    {
+        network::sort(array.data(), N);
+    }
+    else if constexpr(N > 1)
+    {
+        constexpr size_t padded = std::bit_ceil(N);
+
+        alignas(64) T buffer[padded];
+
+        std::memcpy(buffer, array.data(), N * sizeof(T));
+
+        for(size_t i = N; i < padded; i++)
+            buffer[i] = network::sentinel<T>();
+
+        network::sort(buffer, padded);
+
+        std::memcpy(array.data(), buffer, N * sizeof(T));
+    }
+}
+
+// quicksort that hands every partition of network::max_size or fewer keys to the network
+template<network::is_key T>
+void network_sort(T *data, size_t n)
+{
+    while(n > network::max_size)
+    {
+        T a = data[0];
+        T b = data[n / 2];
+        T c = data[n - 1];
+
+        // median of three
+        T pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        size_t i = 0;
+        size_t j = n - 1;
+
+        while(true)
+        {
+            while(data[i] < pivot)
+                i++;
+            while(pivot < data[j])
+                j--;
+
+            if(i >= j)
+                break;
+
+            T temp  = data[i];
+            data[i] = data[j];
+            data[j] = temp;
+
+            i++;
+            j--;
+        }
+
+        size_t left = j + 1;
+
+        // recursing into the smaller side keeps the stack logarithmic
+        if(left < n - left)
+        {
+            network_sort(data, left);
+            data += left;
+            n    -= left;
+        }
+        else
+        {
+            network_sort(data + left, n - left);
+            n = left;
+        }
+    }
+
+    sort_network(data, n);
+}
+
+template<is_container C>
+requires network::is_key<std::remove_cvref_t<decltype(*std::declval<C&>().data())>>
+void network_sort(C &container)
+{
+    network_sort(container.data(), container.size());
+}
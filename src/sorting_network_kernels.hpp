@@ -0,0 +1,141 @@
+// no include guard, sorting_network.hpp includes this once per instruction set inside a namespace that defines
+// Lanes<T>, one register of keys, with the matching #pragma GCC target active so the drivers inline the intrinsics
+
+// strides of at least a register compare two registers, shorter strides permute a register against itself
+template<class L>
+void bitonic(typename L::type *data, size_t n)
+{
+    using reg = typename L::reg;
+
+    constexpr size_t width = L::width;
+
+    for(size_t k = 2; k <= n; k <<= 1)
+    {
+        for(size_t j = k >> 1; j > 0; j >>= 1)
+        {
+            if(j >= width)
+            {
+                for(size_t i = 0; i < n; i += width)
+                {
+                    if(i & j)
+                        continue;
+
+                    reg a = L::load(data + i);
+                    reg b = L::load(data + i + j);
+
+                    reg lo = L::min(a, b);
+                    reg hi = L::max(a, b);
+
+                    bool up = (i & k) == 0;
+
+                    L::store(data + i,     up ? lo : hi);
+                    L::store(data + i + j, up ? hi : lo);
+                }
+
+                continue;
+            }
+
+            auto partner = L::partner(j);
+            auto up      = L::lanes(j, k, true);
+            auto down    = L::lanes(j, k, false);
+
+            for(size_t i = 0; i < n; i += width)
+            {
+                reg v = L::load(data + i);
+                reg p = L::permute(v, partner);
+
+                bool ascending = k < width || (i & k) == 0;
+
+                L::store(data + i, L::blend(L::max(v, p), L::min(v, p), ascending ? up : down));
+            }
+        }
+    }
+}
+
+// the same network over two arrays of 64 bit lanes, a pair orders by key and then by index
+// one mask decides the swap for both registers so an index never leaves its key
+template<class L>
+void bitonic_pairs(uint64_t *keys, uint64_t *index, size_t n)
+{
+    using reg = typename L::reg;
+
+    constexpr size_t width = L::width;
+
+    for(size_t k = 2; k <= n; k <<= 1)
+    {
+        for(size_t j = k >> 1; j > 0; j >>= 1)
+        {
+            if(j >= width)
+            {
+                for(size_t i = 0; i < n; i += width)
+                {
+                    if(i & j)
+                        continue;
+
+                    reg ak = L::load(keys + i);
+                    reg ai = L::load(index + i);
+                    reg bk = L::load(keys + i + j);
+                    reg bi = L::load(index + i + j);
+
+                    auto swap = L::pair_greater(ak, ai, bk, bi);
+
+                    bool up = (i & k) == 0;
+
+                    size_t lo = up ? i : i + j;
+                    size_t hi = up ? i + j : i;
+
+                    L::store(keys + lo,  L::blend(ak, bk, swap));
+                    L::store(index + lo, L::blend(ai, bi, swap));
+                    L::store(keys + hi,  L::blend(bk, ak, swap));
+                    L::store(index + hi, L::blend(bi, ai, swap));
+                }
+
+                continue;
+            }
+
+            auto partner = L::partner(j);
+            auto up      = L::lanes(j, k, true);
+            auto down    = L::lanes(j, k, false);
+
+            for(size_t i = 0; i < n; i += width)
+            {
+                reg vk = L::load(keys + i);
+                reg vi = L::load(index + i);
+                reg pk = L::permute(vk, partner);
+                reg pi = L::permute(vi, partner);
+
+                auto greater = L::pair_greater(vk, vi, pk, pi);
+                auto take    = k < width || (i & k) == 0 ? up : down;
+
+                // the lanes that take the min get the partner where this lane is the greater one
+                reg min_k = L::blend(vk, pk, greater);
+                reg min_i = L::blend(vi, pi, greater);
+                reg max_k = L::blend(pk, vk, greater);
+                reg max_i = L::blend(pi, vi, greater);
+
+                L::store(keys + i,  L::blend(max_k, min_k, take));
+                L::store(index + i, L::blend(max_i, min_i, take));
+            }
+        }
+    }
+}
+
+// false if the batch is narrower than a register, the caller falls back to the scalar network then
+template<is_key T>
+bool sort(T *data, size_t n)
+{
+    if(n < Lanes<T>::width)
+        return false;
+
+    bitonic<Lanes<T>>(data, n);
+    return true;
+}
+
+inline bool sort_pairs(uint64_t *keys, uint64_t *index, size_t n)
+{
+    if(n < Lanes<uint64_t>::width)
+        return false;
+
+    bitonic_pairs<Lanes<uint64_t>>(keys, index, n);
+    return true;
+}
@@ -1,7 +1,6 @@
 #pragma once
 
-#include "forward_list.hpp"
-#include "double_list.hpp"
+#include "deque.hpp"
 
 template<typename T>
 class Stack
@@ -10,23 +9,21 @@ public:
 
     Stack() = default;
 
-    Stack(std::initializer_list<T> init_list) : m_list(init_list), m_size(init_list.size()) {}
+    Stack(std::initializer_list<T> init_list) : m_list(init_list) {}
 
     void push(T item)
     {
-        m_list.push_back(item);
-        m_size++;
+        m_list.push_back(std::move(item));
     }
 
     void pop()
     {
         m_list.pop_back();
-        m_size--;
     }
 
     bool empty() const
     {
-        return m_size == 0;
+        return m_list.empty();
     }
 
     T peek()
@@ -41,10 +38,9 @@ public:
 
     size_t size() const
     {
-        return m_size;
+        return m_list.size();
     }
 
 private:
-    size_t m_size;
-    List<T> m_list;
+    Deque<T> m_list;
 };
\ No newline at end of file
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <iostream>
+
+#include "util.hpp"
+#include "common.hpp"
+
+// a Vector with its capacity fixed at N and the items stored inline, nothing is allocated so it works
+// in constant expressions as well as at runtime, adding past N throws
+//
+//     constexpr auto squares = [] { StaticVector<int, 8> v; for(int i = 0; i < 8; i++) v.push_back(i * i); return v; }();
+//
+// the storage is an array of N value initialized items, so T has to be default constructible,
+// removed items are reset to T() rather than destroyed
+template<typename T, size_t N>
+class StaticVector
+{
+    static_assert(N > 0, "StaticVector needs room for at least one item");
+    static_assert(std::is_default_constructible_v<T>, "StaticVector keeps N constructed items");
+
+public:
+
+    constexpr StaticVector() = default;
+
+    constexpr StaticVector(std::initializer_list<T> items)
+    {
+        if(items.size() > N)
+            throw std::out_of_range("Too many items for the vector");
+
+        for(auto &item : items)
+            m_data[m_size++] = item;
+    }
+
+    constexpr void push_back(const T& item)
+    {
+        check_space();
+        m_data[m_size++] = item;
+    }
+
+    constexpr void push_back(T&& item)
+    {
+        check_space();
+        m_data[m_size++] = std::move(item);
+    }
+
+    template<typename... A>
+    constexpr T& emplace_back(A&& ...a)
+    {
+        check_space();
+        m_data[m_size] = T(std::forward<A>(a)...);
+        return m_data[m_size++];
+    }
+
+    constexpr void pop_back()
+    {
+        if(empty())
+            return;
+
+        m_data[--m_size] = T();
+    }
+
+    // swaps the desired index to the last index and pops it
+    constexpr void swap_pop(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        if(index != m_size - 1)
+            m_data[index] = std::move(m_data[m_size - 1]);
+
+        pop_back();
+    }
+
+    constexpr void insert(size_t index, const T& item)
+    {
+        if(index > m_size)
+            return;
+
+        check_space();
+
+        for(size_t i = m_size; i > index; i--)
+            m_data[i] = std::move(m_data[i - 1]);
+
+        m_data[index] = item;
+        m_size++;
+    }
+
+    constexpr void erase(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        for(size_t i = index; i + 1 < m_size; i++)
+            m_data[i] = std::move(m_data[i + 1]);
+
+        pop_back();
+    }
+
+    constexpr void clear()
+    {
+        while(m_size)
+            m_data[--m_size] = T();
+    }
+
+    [[nodiscard]]
+    constexpr bool includes(const T& item) const
+    {
+        return container::includes(*this, item);
+    }
+
+    // npos if item is not there
+    [[nodiscard]]
+    constexpr size_t index_of(const T& item, size_t offset = 0) const
+    {
+        return container::index_of(*this, item, offset);
+    }
+
+    [[nodiscard]]
+    constexpr T sum() const
+    {
+        return empty() ? T() : container::sum(*this);
+    }
+
+    [[nodiscard]]
+    constexpr T& operator[](size_t index) { return get_element(index); }
+
+    [[nodiscard]]
+    constexpr const T& operator[](size_t index) const { return get_element(index); }
+
+    [[nodiscard]]
+    constexpr T& at(size_t index) { return get_element(index); }
+
+    [[nodiscard]]
+    constexpr const T& at(size_t index) const { return get_element(index); }
+
+    [[nodiscard]]
+    constexpr T& front() { return get_element(0); }
+
+    [[nodiscard]]
+    constexpr const T& front() const { return get_element(0); }
+
+    [[nodiscard]]
+    constexpr T& back() { return get_element(m_size - 1); }
+
+    [[nodiscard]]
+    constexpr const T& back() const { return get_element(m_size - 1); }
+
+    [[nodiscard]]
+    constexpr T* begin() { return m_data; }
+
+    [[nodiscard]]
+    constexpr T* end() { return m_data + m_size; }
+
+    [[nodiscard]]
+    constexpr const T* begin() const { return m_data; }
+
+    [[nodiscard]]
+    constexpr const T* end() const { return m_data + m_size; }
+
+    [[nodiscard]]
+    constexpr T* data() { return m_data; }
+
+    [[nodiscard]]
+    constexpr const T* data() const { return m_data; }
+
+    [[nodiscard]]
+    constexpr size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    static constexpr size_t capacity() { return N; }
+
+    [[nodiscard]]
+    constexpr bool empty() const { return m_size == 0; }
+
+    [[nodiscard]]
+    constexpr bool full() const { return m_size == N; }
+
+    [[nodiscard]]
+    friend constexpr bool operator==(const StaticVector& a, const StaticVector& b)
+    {
+        if(a.m_size != b.m_size)
+            return false;
+
+        for(size_t i = 0; i < a.m_size; i++)
+        {
+            if(!(a.m_data[i] == b.m_data[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const StaticVector& vec)
+    {
+        return os << to_string(vec);
+    }
+
+private:
+    T      m_data[N]{};
+    size_t m_size = 0;
+
+    constexpr void check_space() const
+    {
+        if(m_size == N)
+            throw std::out_of_range("StaticVector is full");
+    }
+
+    constexpr T& get_element(size_t index)
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return m_data[index];
+    }
+
+    constexpr const T& get_element(size_t index) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Index is out of range");
+        return m_data[index];
+    }
+};
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "concurrent_queue.hpp"
+#include "deque.hpp"
+#include "range.hpp"
+
+// Chase-Lev work stealing deque, the C11 formulation from Le, Pop, Cohen and Zappa Nardelli
+// the owning thread pushes and pops at the bottom like a stack while any other thread steals from the top,
+// only the last item left ever needs a CAS between the owner and a thief
+// T has to be trivially copyable, the pool stores task pointers in it
+template<class T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+
+    explicit WorkStealingDeque(size_t capacity = 64)
+    {
+        m_rings.push_back(std::make_unique<Ring>(std::bit_ceil(capacity < 2 ? 2 : capacity)));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // owner only
+    void push(T item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top    = m_top.load(std::memory_order_acquire);
+        Ring   *ring   = m_ring.load(std::memory_order_relaxed);
+
+        if(bottom - top > int64_t(ring->capacity) - 1)
+            ring = grow(ring, top, bottom);
+
+        ring->put(bottom, item);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // owner only, takes the most recently pushed item
+    bool pop(T &item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring   *ring   = m_ring.load(std::memory_order_relaxed);
+
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if(top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = ring->get(bottom);
+
+        if(top == bottom)
+        {
+            // the last item, whoever moves top first gets it
+            bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+            return won;
+        }
+
+        return true;
+    }
+
+    // any thread, takes the oldest item
+    bool steal(T &item)
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+        if(top >= bottom)
+            return false;
+
+        Ring *ring = m_ring.load(std::memory_order_acquire);
+
+        item = ring->get(top);
+
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // only a snapshot while other threads are running
+    [[nodiscard]]
+    size_t size() const
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top    = m_top.load(std::memory_order_relaxed);
+
+        return bottom > top ? bottom - top : 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const { return size() == 0; }
+
+private:
+
+    struct Ring
+    {
+        size_t capacity;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Ring(size_t capacity) : capacity(capacity), items(new std::atomic<T>[capacity]) {}
+
+        inline T get(int64_t index) const
+        {
+            return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        inline void put(int64_t index, T item)
+        {
+            items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(cache_line) std::atomic<int64_t> m_top{0};
+    alignas(cache_line) std::atomic<int64_t> m_bottom{0};
+    alignas(cache_line) std::atomic<Ring*>   m_ring;
+
+    // a thief may still be reading an old ring so they are only freed with the deque
+    std::vector<std::unique_ptr<Ring>> m_rings;
+
+    Ring* grow(Ring *ring, int64_t top, int64_t bottom)
+    {
+        auto bigger = std::make_unique<Ring>(ring->capacity * 2);
+
+        for(int64_t i = top; i < bottom; i++)
+            bigger->put(i, ring->get(i));
+
+        m_rings.push_back(std::move(bigger));
+        m_ring.store(m_rings.back().get(), std::memory_order_release);
+
+        return m_rings.back().get();
+    }
+};
+
+// thread pool where every worker owns a work stealing deque
+// tasks spawned from inside a worker go to its own deque, tasks from other threads go through a shared injection queue,
+// idle workers steal before they go to sleep and threads that wait on parallel work run tasks instead of blocking
+class ThreadPool
+{
+public:
+
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threads = 0)
+    {
+        if(threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if(threads == 0)
+            threads = 1;
+
+        for(size_t i = 0; i < threads; i++)
+            m_deques.push_back(std::make_unique<WorkStealingDeque<Task*>>());
+
+        for(size_t i = 0; i < threads; i++)
+            m_workers.emplace_back([this, i] { work(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_wake.notify_all();
+
+        for(auto &worker : m_workers)
+            worker.join();
+
+        Task *task;
+
+        while(take(npos, task))
+            delete task;
+    }
+
+    // shared by everything that does not bring its own pool
+    static ThreadPool& global()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    template<typename FN>
+    auto submit(FN fn) -> std::future<std::invoke_result_t<FN>>
+    {
+        using R = std::invoke_result_t<FN>;
+
+        auto task   = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+        auto future = task->get_future();
+
+        schedule(new Task([task] { (*task)(); }));
+
+        return future;
+    }
+
+    // calls fn(i) for every i in the range, the calling thread joins in until every chunk is done
+    template<typename FN>
+    void parallel_for(const range &r, FN fn)
+    {
+        run_chunks(r.size(), [&](size_t first, size_t last)
+        {
+            for(size_t i = first; i < last; i++)
+                fn(r[i]);
+        });
+    }
+
+    // folds map(i) over the range with reduce, init has to be the identity of reduce
+    // each chunk folds on its own and the chunks are combined in order so the grouping only depends on the chunking
+    template<typename T, typename Map, typename Reduce>
+    T parallel_reduce(const range &r, T init, Map map, Reduce reduce)
+    {
+        std::vector<T> partial(chunk_count(r.size()), init);
+
+        run_chunks(r.size(), [&](size_t first, size_t last)
+        {
+            T local = init;
+
+            for(size_t i = first; i < last; i++)
+                local = reduce(local, map(r[i]));
+
+            partial[first / chunk_size(r.size())] = local;
+        });
+
+        T result = init;
+
+        for(auto &value : partial)
+            result = reduce(result, value);
+
+        return result;
+    }
+
+    // splits [0, count) into chunks and runs fn(first, last) on each, rethrows the first exception a chunk threw
+    template<typename FN>
+    void run_chunks(size_t count, FN fn)
+    {
+        if(count == 0)
+            return;
+
+        const size_t size   = chunk_size(count);
+        const size_t chunks = chunk_count(count);
+
+        std::atomic<size_t> remaining{chunks};
+        std::exception_ptr  error;
+        std::mutex          error_mutex;
+
+        for(size_t c = 1; c < chunks; c++)
+        {
+            schedule(new Task([&, c]
+            {
+                try
+                {
+                    fn(c * size, std::min(count, (c + 1) * size));
+                }
+                catch(...)
+                {
+                    std::lock_guard lock(error_mutex);
+
+                    if(!error)
+                        error = std::current_exception();
+                }
+
+                remaining.fetch_sub(1, std::memory_order_release);
+            }));
+        }
+
+        try
+        {
+            fn(0, std::min(count, size));
+        }
+        catch(...)
+        {
+            std::lock_guard lock(error_mutex);
+
+            if(!error)
+                error = std::current_exception();
+        }
+
+        remaining.fetch_sub(1, std::memory_order_release);
+
+        while(remaining.load(std::memory_order_acquire) != 0)
+        {
+            if(!run_one())
+                std::this_thread::yield();
+        }
+
+        if(error)
+            std::rethrow_exception(error);
+    }
+
+    // runs one pending task on the calling thread, returns false if there was nothing to run
+    bool run_one()
+    {
+        Task *task;
+
+        if(!take(worker_index(), task))
+            return false;
+
+        execute(task);
+
+        return true;
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_workers.size(); }
+
+private:
+    std::vector<std::unique_ptr<WorkStealingDeque<Task*>>> m_deques;
+    std::vector<std::thread>                               m_workers;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    Deque<Task*>            m_injected;
+    std::atomic<size_t>     m_pending{0};
+    bool                    m_stop = false;
+
+    static inline thread_local ThreadPool *t_pool  = nullptr;
+    static inline thread_local size_t      t_index = 0;
+
+    // a few chunks per worker so a slow chunk does not hold up the rest
+    size_t chunk_count(size_t count) const
+    {
+        return (count + chunk_size(count) - 1) / chunk_size(count);
+    }
+
+    size_t chunk_size(size_t count) const
+    {
+        size_t chunks = m_workers.size() * 4;
+        return (count + chunks - 1) / chunks;
+    }
+
+    // npos when the calling thread is not one of this pool's workers
+    size_t worker_index() const
+    {
+        return t_pool == this ? t_index : npos;
+    }
+
+    void schedule(Task *task)
+    {
+        size_t self = worker_index();
+
+        if(self != npos)
+        {
+            m_deques[self]->push(task);
+        }
+        else
+        {
+            std::lock_guard lock(m_mutex);
+            m_injected.push_back(task);
+        }
+
+        m_pending.fetch_add(1, std::memory_order_release);
+
+        // taking the lock orders the increment before a sleeping worker re-checks it
+        {
+            std::lock_guard lock(m_mutex);
+        }
+
+        m_wake.notify_one();
+    }
+
+    // own deque first, then the injection queue, then the other workers starting from a neighbour
+    bool take(size_t self, Task *&task)
+    {
+        if(self != npos && m_deques[self]->pop(task))
+            return taken();
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            if(!m_injected.empty())
+            {
+                task = m_injected.front();
+                m_injected.pop_front();
+                return taken();
+            }
+        }
+
+        size_t count = m_deques.size();
+        size_t start = self == npos ? 0 : self + 1;
+
+        for(size_t i = 0; i < count; i++)
+        {
+            size_t victim = (start + i) % count;
+
+            if(victim != self && m_deques[victim]->steal(task))
+                return taken();
+        }
+
+        return false;
+    }
+
+    inline bool taken()
+    {
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    static void execute(Task *task)
+    {
+        (*task)();
+        delete task;
+    }
+
+    void work(size_t index)
+    {
+        t_pool  = this;
+        t_index = index;
+
+        while(true)
+        {
+            Task *task;
+
+            if(take(index, task))
+            {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock lock(m_mutex);
+
+            m_wake.wait(lock, [this]
+            {
+                return m_stop || m_pending.load(std::memory_order_acquire) > 0;
+            });
+
+            if(m_stop)
+                return;
+        }
+    }
+};
@@ -65,9 +65,13 @@ public:
         }
 
         node->value = std::forward<T>(value);
-        node->end = true;
 
-        m_size++;
+        if (!node->end)
+        {
+            m_size++;
+        }
+
+        node->end = true;
 
         return node;
     }
@@ -82,6 +86,11 @@ public:
         for (char c : key)
         {
             node = node->data[c];
+
+            if (node == nullptr)
+            {
+                return nullptr;
+            }
         }
 
         return node;
@@ -90,30 +99,25 @@ public:
     T* get(std::string_view key) const
     {
         auto node = get_node(m_root, key);
-        return node ? &node->value : nullptr;
+        return node && node->end ? &node->value : nullptr;
     }
 
-    void erase(std::string_view key)
+    // unmarks the key, the nodes stay for the next key that shares the path
+    bool erase(std::string_view key)
     {
-        auto node = m_root;
-        auto last = node;
-
-        int i;
+        auto node = get_node(m_root, key);
 
-        for (i = 0; i < N; i++)
+        if (node == nullptr || !node->end)
         {
-            if (node != nullptr)
-            {
-                last = node;
-                node = node->data[key[i]];
-            }
+            return false;
         }
 
-        last->data[i] = nullptr;
-
-        delete node;
+        node->end = false;
+        node->value = T();
 
         m_size--;
+
+        return true;
     }
 
     size_t size() const 
@@ -134,7 +138,7 @@ private:
 
         if (node->end)
         {
-            vec.push_back(std::move(buff));
+            vec.push_back(buff);
         }
 
         for (int i = 0; i < N; i++)
@@ -0,0 +1,480 @@
+#pragma once
+
+#include <initializer_list>
+#include <stdexcept>
+#include <functional>
+#include <utility>
+#include <new>
+#include <list>
+#include <chrono>
+#include <iostream>
+
+#include "util.hpp"
+#include "double_list.hpp"
+
+// unrolled linked list, a doubly linked list of blocks that each hold a run of items
+// a block spans Lines cache lines so walking the list touches memory in order and indexing skips a whole block per hop,
+// the link overhead is shared by every item in the block instead of two pointers per item
+// full blocks split in half on insert and sparse blocks merge with their neighbour on erase so blocks stay at least a quarter full
+template<class T, size_t Lines = 4>
+class UnrolledList
+{
+    struct Block;
+
+    static constexpr size_t header = sizeof(void*) * 2 + sizeof(size_t);
+
+public:
+
+    // items per block, at least 8 however large T is
+    static constexpr size_t block_capacity = (Lines * cache_line - header) / sizeof(T) > 8 ? (Lines * cache_line - header) / sizeof(T) : 8;
+
+    class Iterator;
+
+    UnrolledList() = default;
+
+    UnrolledList(std::initializer_list<T> init_list)
+    {
+        for(auto &data : init_list)
+            push_back(data);
+    }
+
+    UnrolledList(const UnrolledList& other)
+    {
+        for(auto &data : other)
+            push_back(data);
+    }
+
+    UnrolledList(UnrolledList&& other) noexcept
+    {
+        move_from(std::move(other));
+    }
+
+    ~UnrolledList()
+    {
+        clear();
+    }
+
+    UnrolledList& operator=(const UnrolledList& other)
+    {
+        if(this != &other)
+        {
+            clear();
+
+            for(auto &data : other)
+                push_back(data);
+        }
+
+        return *this;
+    }
+
+    UnrolledList& operator=(UnrolledList&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+            move_from(std::move(other));
+        }
+
+        return *this;
+    }
+
+    void push_back(T data)
+    {
+        // appending fills blocks to the brim since nothing will be inserted in front of the tail's items
+        if(!m_tail || m_tail->count == block_capacity)
+            link_after(m_tail, new Block());
+
+        m_tail->construct(m_tail->count, std::move(data));
+        m_tail->count++;
+        m_size++;
+    }
+
+    void push(T data)
+    {
+        if(!m_head || m_head->count == block_capacity)
+            link_after(nullptr, new Block());
+
+        m_head->insert(0, std::move(data));
+        m_size++;
+    }
+
+    // index == size appends, anything past that is ignored like in Forward_List
+    void insert(size_t index, T data)
+    {
+        if(index > m_size)
+            return;
+        if(index == m_size)
+            return push_back(std::move(data));
+
+        auto [block, offset] = locate(index);
+
+        if(block->count == block_capacity)
+        {
+            Block *half = split(block);
+
+            if(offset > block->count)
+            {
+                offset -= block->count;
+                block   = half;
+            }
+        }
+
+        block->insert(offset, std::move(data));
+        m_size++;
+    }
+
+    void erase(size_t index)
+    {
+        if(index >= m_size)
+            return;
+
+        auto [block, offset] = locate(index);
+
+        remove(block, offset);
+    }
+
+    void pop()
+    {
+        if(m_size == 0)
+            return;
+
+        remove(m_head, 0);
+    }
+
+    void pop_back()
+    {
+        if(m_size == 0)
+            return;
+
+        remove(m_tail, m_tail->count - 1);
+    }
+
+    void clear()
+    {
+        Block *block = m_head;
+
+        while(block)
+        {
+            Block *next = block->next;
+
+            block->destroy_all();
+            delete block;
+
+            block = next;
+        }
+
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+    T& operator[](size_t index)
+    {
+        if(index >= m_size)
+            throw std::out_of_range("Out of range");
+
+        auto [block, offset] = locate(index);
+
+        return block->at(offset);
+    }
+
+    const T& operator[](size_t index) const
+    {
+        return const_cast<UnrolledList&>(*this)[index];
+    }
+
+    T& front() { return m_head ? m_head->at(0) : throw std::out_of_range("Out of range"); }
+    T& back()  { return m_tail ? m_tail->at(m_tail->count - 1) : throw std::out_of_range("Out of range"); }
+
+    void foreach(std::function<void(T&)> fn)
+    {
+        for(Block *block = m_head; block; block = block->next)
+        {
+            for(size_t i = 0; i < block->count; i++)
+                fn(block->at(i));
+        }
+    }
+
+    [[nodiscard]]
+    size_t size() const { return m_size; }
+
+    [[nodiscard]]
+    bool empty() const { return m_size == 0; }
+
+    // how many blocks the items are spread over
+    [[nodiscard]]
+    size_t blocks() const
+    {
+        size_t count = 0;
+
+        for(Block *block = m_head; block; block = block->next)
+            count++;
+
+        return count;
+    }
+
+    // bytes held by the blocks
+    [[nodiscard]]
+    size_t memory() const { return blocks() * sizeof(Block); }
+
+    Iterator begin() const { return Iterator(m_head, 0); }
+    Iterator end() const { return Iterator(nullptr, 0); }
+
+private:
+
+    struct alignas(cache_line) Block
+    {
+        Block  *prev  = nullptr;
+        Block  *next  = nullptr;
+        size_t  count = 0;
+
+        alignas(T) unsigned char storage[block_capacity * sizeof(T)];
+
+        inline T& at(size_t index) { return reinterpret_cast<T*>(storage)[index]; }
+
+        inline void construct(size_t index, T&& data) { new (&at(index)) T(std::move(data)); }
+
+        // shifts the tail of the block up by one and puts data in the gap
+        void insert(size_t index, T&& data)
+        {
+            if(index == count)
+            {
+                construct(count, std::move(data));
+                count++;
+                return;
+            }
+
+            construct(count, std::move(at(count - 1)));
+
+            for(size_t i = count - 1; i > index; i--)
+                at(i) = std::move(at(i - 1));
+
+            at(index) = std::move(data);
+            count++;
+        }
+
+        void erase(size_t index)
+        {
+            for(size_t i = index; i + 1 < count; i++)
+                at(i) = std::move(at(i + 1));
+
+            count--;
+            at(count).~T();
+        }
+
+        // moves the items from first onwards to the end of other
+        void move_to(size_t first, Block *other)
+        {
+            for(size_t i = first; i < count; i++)
+            {
+                other->construct(other->count++, std::move(at(i)));
+                at(i).~T();
+            }
+
+            count = first;
+        }
+
+        void destroy_all()
+        {
+            for(size_t i = 0; i < count; i++)
+                at(i).~T();
+
+            count = 0;
+        }
+    };
+
+    Block  *m_head = nullptr;
+    Block  *m_tail = nullptr;
+    size_t  m_size = 0;
+
+    // walks from whichever end is closer, a whole block per step
+    std::pair<Block*, size_t> locate(size_t index) const
+    {
+        if(index < m_size / 2)
+        {
+            Block *block = m_head;
+
+            while(index >= block->count)
+            {
+                index -= block->count;
+                block  = block->next;
+            }
+
+            return { block, index };
+        }
+
+        Block  *block = m_tail;
+        size_t  after = m_size - index;
+
+        while(after > block->count)
+        {
+            after -= block->count;
+            block  = block->prev;
+        }
+
+        return { block, block->count - after };
+    }
+
+    // prev == nullptr links the block in as the new head
+    void link_after(Block *prev, Block *block)
+    {
+        Block *next = prev ? prev->next : m_head;
+
+        block->prev = prev;
+        block->next = next;
+
+        if(prev)
+            prev->next = block;
+        else
+            m_head = block;
+
+        if(next)
+            next->prev = block;
+        else
+            m_tail = block;
+    }
+
+    void unlink(Block *block)
+    {
+        if(block->prev)
+            block->prev->next = block->next;
+        else
+            m_head = block->next;
+
+        if(block->next)
+            block->next->prev = block->prev;
+        else
+            m_tail = block->prev;
+
+        delete block;
+    }
+
+    // moves the upper half of a full block into a new block right after it
+    Block* split(Block *block)
+    {
+        Block *half = new Block();
+
+        block->move_to(block->count / 2, half);
+        link_after(block, half);
+
+        return half;
+    }
+
+    void remove(Block *block, size_t offset)
+    {
+        block->erase(offset);
+        m_size--;
+
+        if(block->count == 0)
+        {
+            unlink(block);
+            return;
+        }
+
+        if(block->count >= block_capacity / 4)
+            return;
+
+        // too sparse, fold into a neighbour when the two fit in one block
+        if(block->next && block->count + block->next->count <= block_capacity)
+        {
+            block->next->move_to(0, block);
+            unlink(block->next);
+        }
+        else if(block->prev && block->prev->count + block->count <= block_capacity)
+        {
+            block->move_to(0, block->prev);
+            unlink(block);
+        }
+    }
+
+    void move_from(UnrolledList&& other)
+    {
+        m_head = other.m_head;
+        m_tail = other.m_tail;
+        m_size = other.m_size;
+
+        other.m_head = nullptr;
+        other.m_tail = nullptr;
+        other.m_size = 0;
+    }
+};
+
+template<class T, size_t Lines>
+class UnrolledList<T, Lines>::Iterator
+{
+public:
+    Iterator(Block *block, size_t offset) : m_block(block), m_offset(offset) {}
+
+    T& operator*() const { return m_block->at(m_offset); }
+
+    Iterator& operator++()
+    {
+        if(++m_offset == m_block->count)
+        {
+            m_block  = m_block->next;
+            m_offset = 0;
+        }
+
+        return *this;
+    }
+
+    Iterator operator++(int)
+    {
+        Iterator temp = *this;
+        ++*this;
+        return temp;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_block == b.m_block && a.m_offset == b.m_offset; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return !(a == b); }
+
+private:
+    Block  *m_block;
+    size_t  m_offset;
+};
+
+// iteration and indexed access against List and std::list
+void unrolled_list_bench(const size_t target)
+{
+    using namespace std::chrono;
+
+    UnrolledList<size_t> unrolled;
+    List<size_t>         list;
+    std::list<size_t>    stl;
+
+    for(size_t i = 0; i < target; i++)
+    {
+        unrolled.push_back(i);
+        list.push_back(i);
+        stl.push_back(i);
+    }
+
+    auto time = [](auto fn)
+    {
+        auto start = steady_clock::now();
+        size_t sum = fn();
+        auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+
+        // keeps the work from being optimized out
+        if(sum == 1)
+            std::cout << ' ';
+
+        return elapsed;
+    };
+
+    auto unrolled_walk = time([&] { size_t sum = 0; for(auto n : unrolled) sum += n; return sum; });
+    auto stl_walk      = time([&] { size_t sum = 0; for(auto n : stl) sum += n; return sum; });
+
+    // a strided sample of indices, a full sweep of List::operator[] would be quadratic
+    const size_t samples = 1000;
+
+    auto unrolled_index = time([&] { size_t sum = 0; for(size_t i = 0; i < samples; i++) sum += unrolled[i * (target / samples)]; return sum; });
+    auto list_index     = time([&] { size_t sum = 0; for(size_t i = 0; i < samples; i++) sum += list[i * (target / samples)]; return sum; });
+
+    std::cout
+            << target << " items\n"
+            << "  iterate   UnrolledList: " << unrolled_walk  << "  std::list: " << stl_walk   << '\n'
+            << "  operator[] UnrolledList: " << unrolled_index << "  List:      " << list_index << '\n'
+            << "  bytes per item UnrolledList: " << double(unrolled.memory()) / double(target)
+            << "  std::list: " << double(sizeof(size_t) + 2 * sizeof(void*)) << " + allocator overhead\n";
+}
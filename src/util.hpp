@@ -17,6 +17,9 @@ concept is_container = requires(T t)
 
 static constexpr size_t npos = -1;
 
+// what alignas pads hot data out to so neighbours never share a line
+static constexpr size_t cache_line = 64;
+
 template<is_container T>
 std::string to_string(const T& container)
 {
@@ -120,11 +123,11 @@ std::string rand_str(size_t max_len)
 }
 
 template<typename T>
-void swap(T& a, T& b)
+constexpr void swap(T& a, T& b)
 {
-    T temp = a;
-    a = b;
-    b = temp;
+    T temp = std::move(a);
+    a = std::move(b);
+    b = std::move(temp);
 }
 
 template<class FN, typename... Args>
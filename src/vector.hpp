@@ -3,6 +3,7 @@
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
+#include <type_traits>
 #include <iostream>
 
 #include "util.hpp"
@@ -108,7 +109,12 @@ public:
     {
         if(empty())
             return;
-        m_data[--m_size].~T();
+
+        // the slot stays alive until delete[] so it is reset instead of destroyed
+        if constexpr(std::is_trivially_destructible_v<T>)
+            m_size--;
+        else
+            m_data[--m_size] = T();
     }
 
     // swaps the index of a and b
@@ -245,6 +251,22 @@ public:
         return container::sum(*this);
     }
 
+    // throws if the vector is empty
+    T min() const
+    {
+        return container::min(*this);
+    }
+
+    T max() const
+    {
+        return container::max(*this);
+    }
+
+    size_t count(const T& item) const
+    {
+        return container::count(*this, item);
+    }
+
     friend Vector<T> operator+(Vector<T>& a, Vector<T>& b)
     {
         a.resize(a.size()+b.size()+1);